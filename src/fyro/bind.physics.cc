@@ -2,6 +2,7 @@
 
 #include "lox/lox.h"
 
+#include "fyro/cooked.h"
 #include "fyro/log.h"
 #include "fyro/vfs.h"
 #include "fyro/io.h"
@@ -161,6 +162,7 @@ struct ScriptActorImpl : fyro::Actor
 {
 	lox::Interpreter* inter;
 	std::shared_ptr<ScriptActor> dispatcher;
+	std::string collision_class;	// the collision handlers this actor is sent to
 
 	explicit ScriptActorImpl(lox::Interpreter* interpreter) : inter(interpreter) {}
 
@@ -239,96 +241,199 @@ struct ScriptSolidBase
 	std::shared_ptr<ScriptSolidImpl> impl;
 };
 
-struct FixedSolid : fyro::Solid
+namespace
 {
-	void update(float) override
-	{
-	}
+	// increase when the cooked level or map changes
+	constexpr u32 cooked_level_version = 4;
 
-	void render(RenderData*, std::shared_ptr<lox::Object>) override
+	/** A tmx object that is spawned by the callback registered for its tileset */
+	struct ObjectSpawn
 	{
-	}
-};
+		std::string tileset_name;
+		glm::ivec2 position;  // in world space
+
+		// only used to warn about objects without a callback
+		u32 uid;
+		std::string type;
+		std::string name;
+		u32 tile_id;
+		u32 tileset_index;
+	};
+
+	/** The parts of a level that aren't part of the map */
+	struct LevelSource
+	{
+		// the collisions of the tiles, placed in a grid of the map tiles
+		glm::ivec2 tile_size;
+		glm::ivec2 tile_count;
+		std::vector<Recti> tile_solids;
 
-ScriptLevel::ScriptLevel()
-	: data(std::make_shared<ScriptLevelData>())
-{
-}
+		std::vector<ObjectSpawn> objects;
+	};
 
-void ScriptLevel::load_tmx(lox::Lox* lox, const std::string& path)
-{
-	auto source = read_file_to_string(path);
-	tmx::Map map;
-	const auto was_loaded = map.loadFromString(source, get_dir_from_file(path));
-	if (was_loaded == false)
+	void load_tmx_map(tmx::Map* map, const std::string& path, const std::string& source)
 	{
-		throw Exception{{"failed to parse tmx file"}};
+		const auto was_loaded = map->loadFromString(source, get_dir_from_file(path));
+		if (was_loaded == false)
+		{
+			throw Exception{{"failed to parse tmx file"}};
+		}
 	}
-	data->tiles.load_from_map(map);
 
-	for (const auto& rect: data->tiles.get_collisions())
+	LevelSource get_level_source(const tmx::Map& map, const Map& tiles, const std::string& path)
 	{
-		auto solid = std::make_shared<FixedSolid>();
-		solid->level = &data->level;
+		LevelSource r;
+
+		const auto tile_size = map.getTileSize();
+		const auto tile_count = map.getTileCount();
+		r.tile_size = glm::ivec2{static_cast<int>(tile_size.x), static_cast<int>(tile_size.y)};
+		r.tile_count = glm::ivec2{static_cast<int>(tile_count.x), static_cast<int>(tile_count.y)};
+		std::vector<Recti> tile_rects;
+		for (const auto& rect: tiles.get_collisions())
+		{
+			tile_rects.emplace_back(Recti::from_xywh(
+				static_cast<int>(rect.left),
+				static_cast<int>(rect.bottom),
+				static_cast<int>(rect.get_width()),
+				static_cast<int>(rect.get_height())
+			));
+		}
 
-		solid->position = glm::ivec2{static_cast<int>(rect.left), static_cast<int>(rect.bottom)};
-		solid->size
-			= Recti{static_cast<int>(rect.get_width()), static_cast<int>(rect.get_height())};
+		// fewer and larger rects means fewer rects per grid cell
+		r.tile_solids = fyro::merge_rects(tile_rects);
+		LOG_INFO(
+			"{0}: merged {1} collision rects to {2} in a {3}x{4} tile grid",
+			path,
+			tile_rects.size(),
+			r.tile_solids.size(),
+			r.tile_count.x,
+			r.tile_count.y
+		);
+
+		const auto map_height = static_cast<int>(map.getBounds().height);
+
+		const auto& layer_array = map.getLayers();
+		for (const auto& layer: layer_array)
+		{
+			if (layer->getType() != tmx::Layer::Type::Object) continue;
+			const auto* object_group = static_cast<const tmx::ObjectGroup*>(layer.get());
+
+			// todo(Gustav): move the printing code to a dear imgui inspector
+			// LOG_INFO("Found layer {0}", object_group->getName());
+			// const auto& props_array = object_group->getProperties();
+			// for (const auto& prop: props_array)
+			// {
+			// 	LOG_INFO("Prop {0}", prop.getName());
+			// }
+
+			const auto& tileset_array = map.getTilesets();
+			// for (const auto& tileset: tileset_array)
+			// {
+			// 	LOG_INFO(
+			// 		"Found tileset {0}: {1}-{2}",
+			// 		tileset.getName(),
+			// 		tileset.getFirstGID(),
+			// 		tileset.getLastGID()
+			// 	);
+			// }
+
+			const auto& obj_array = object_group->getObjects();
+			for (const auto& obj: obj_array)
+			{
+				std::size_t tileset_index = 0;
+				for (std::size_t search_index = 0; search_index < tileset_array.size();
+					 search_index += 1)
+				{
+					if (obj.getTileID() < tileset_array[search_index].getFirstGID()) break;
+					tileset_index = search_index;
+				}
+
+				const auto pos = obj.getPosition();
+				// todo(Gustav): why are x and y doubles? shouldn't they be integers?
+				const auto fpx = static_cast<int>(pos.x);
+				const auto fpy = static_cast<int>(pos.y);
+				r.objects.emplace_back(ObjectSpawn{
+					tileset_array[tileset_index].getName(),
+					glm::ivec2{fpx, map_height - fpy},
+					obj.getUID(),
+					obj.getType(),
+					obj.getName(),
+					obj.getTileID(),
+					static_cast<u32>(tileset_index)
+				});
+			}
+		}
 
-		data->level.solids.emplace_back(solid);
+		return r;
 	}
 
-	const auto map_height = static_cast<int>(map.getBounds().height);
+	void write_level_source(CookedWriter* file, const LevelSource& level)
+	{
+		file->write(level.tile_size);
+		file->write(level.tile_count);
+		file->write(static_cast<u32>(level.tile_solids.size()));
+		for (const auto& rect: level.tile_solids)
+		{
+			file->write(glm::ivec4{rect.left, rect.bottom, rect.right, rect.top});
+		}
 
-	// get objects, parse registrered loaders, warn for errors/mismatches
+		file->write(static_cast<u32>(level.objects.size()));
+		for (const auto& obj: level.objects)
+		{
+			file->write_string(obj.tileset_name);
+			file->write(obj.position);
+			file->write(obj.uid);
+			file->write_string(obj.type);
+			file->write_string(obj.name);
+			file->write(obj.tile_id);
+			file->write(obj.tileset_index);
+		}
+	}
 
-	const auto& layer_array = map.getLayers();
-	for (const auto& layer: layer_array)
+	LevelSource read_level_source(CookedReader* file)
 	{
-		if (layer->getType() != tmx::Layer::Type::Object) continue;
-		const auto* object_group = static_cast<const tmx::ObjectGroup*>(layer.get());
-
-		// todo(Gustav): move the printing code to a dear imgui inspector
-		// LOG_INFO("Found layer {0}", object_group->getName());
-		// const auto& props_array = object_group->getProperties();
-		// for (const auto& prop: props_array)
-		// {
-		// 	LOG_INFO("Prop {0}", prop.getName());
-		// }
-
-		const auto& tileset_array = map.getTilesets();
-		// for (const auto& tileset: tileset_array)
-		// {
-		// 	LOG_INFO(
-		// 		"Found tileset {0}: {1}-{2}",
-		// 		tileset.getName(),
-		// 		tileset.getFirstGID(),
-		// 		tileset.getLastGID()
-		// 	);
-		// }
-
-		const auto& obj_array = object_group->getObjects();
-		for (const auto& obj: obj_array)
+		LevelSource r;
+
+		r.tile_size = file->read<glm::ivec2>();
+		r.tile_count = file->read<glm::ivec2>();
+		const auto solid_count = file->read<u32>();
+		for (u32 index = 0; index < solid_count; index += 1)
 		{
-			std::size_t tileset_index = 0;
-			for (std::size_t search_index = 0; search_index < tileset_array.size();
-				 search_index += 1)
-			{
-				if (obj.getTileID() < tileset_array[search_index].getFirstGID()) break;
-				tileset_index = search_index;
-			}
+			const auto rect = file->read<glm::ivec4>();
+			r.tile_solids.emplace_back(rect.x, rect.y, rect.z, rect.w);
+		}
+
+		const auto object_count = file->read<u32>();
+		for (u32 index = 0; index < object_count; index += 1)
+		{
+			auto obj = ObjectSpawn{};
+			obj.tileset_name = file->read_string();
+			obj.position = file->read<glm::ivec2>();
+			obj.uid = file->read<u32>();
+			obj.type = file->read_string();
+			obj.name = file->read_string();
+			obj.tile_id = file->read<u32>();
+			obj.tileset_index = file->read<u32>();
+			r.objects.emplace_back(std::move(obj));
+		}
+
+		return r;
+	}
+
+	void spawn_level(lox::Lox* lox, ScriptLevelData* data, const LevelSource& level)
+	{
+		data->level.tiles
+			= fyro::TileGridCollider{level.tile_size, level.tile_count, level.tile_solids};
 
-			const auto tileset_name = tileset_array[tileset_index].getName();
-			const auto from_tileset_found = data->from_tileset.find(tileset_name);
+		// get objects, parse registrered loaders, warn for errors/mismatches
+		for (const auto& obj: level.objects)
+		{
+			const auto from_tileset_found = data->from_tileset.find(obj.tileset_name);
 			if (from_tileset_found != data->from_tileset.end())
 			{
-				const auto pos = obj.getPosition();
-				// todo(Gustav): why are x and y doubles? shouldn't they be integers?
-				const auto fpx = static_cast<int>(pos.x);
-				const auto fpy = static_cast<int>(pos.y);
-				// LOG_INFO("Spawning {0} at {1} {2}", tileset_name, fpx, fpy);
-				const auto px = lox::make_number_int(fpx);
-				const auto py = lox::make_number_int(map_height - fpy);
+				// LOG_INFO("Spawning {0} at {1} {2}", obj.tileset_name, obj.position.x, obj.position.y);
+				const auto px = lox::make_number_int(obj.position.x);
+				const auto py = lox::make_number_int(obj.position.y);
 				from_tileset_found->second->call(lox->get_interpreter(), {{px, py}});
 			}
 			else
@@ -336,16 +441,106 @@ void ScriptLevel::load_tmx(lox::Lox* lox, const std::string& path)
 				// todo(Gustav): provide a detailed error of possible matches and badly spelled names
 				LOG_WARNING(
 					"Found object called '{2}' #{0} of type '{1}' with tile #{3} from tileset #{4} '{5}' with no callback",
-					obj.getUID(),
-					obj.getType(),
-					obj.getName(),
-					obj.getTileID(),
-					tileset_index,
-					tileset_name
+					obj.uid,
+					obj.type,
+					obj.name,
+					obj.tile_id,
+					obj.tileset_index,
+					obj.tileset_name
 				);
 			}
 		}
 	}
+
+	void call_collision_handlers(
+		const ScriptLevelData& data, ScriptActorImpl* lhs, ScriptActorImpl* rhs
+	)
+	{
+		// a handler might add handlers so the handler is copied and the loop checks the size
+		for (std::size_t index = 0; index < data.collision_handlers.size(); index += 1)
+		{
+			const auto handler = data.collision_handlers[index];
+			if (handler.lhs == lhs->collision_class && handler.rhs == rhs->collision_class)
+			{
+				handler.on_collision->call(
+					lhs->inter, {{lhs->dispatcher->instance, rhs->dispatcher->instance}}
+				);
+			}
+			else if (handler.lhs == rhs->collision_class && handler.rhs == lhs->collision_class)
+			{
+				handler.on_collision->call(
+					lhs->inter, {{rhs->dispatcher->instance, lhs->dispatcher->instance}}
+				);
+			}
+		}
+	}
+}  //  namespace
+
+ScriptLevel::ScriptLevel()
+	: data(std::make_shared<ScriptLevelData>())
+{
+	// all actors in a script level are script actors, see add_actor
+	auto* level_data = data.get();
+	data->level.on_contact = [level_data](fyro::Actor* lhs, fyro::Actor* rhs)
+	{
+		call_collision_handlers(
+			*level_data, static_cast<ScriptActorImpl*>(lhs), static_cast<ScriptActorImpl*>(rhs)
+		);
+	};
+}
+
+void ScriptLevel::load_tmx(lox::Lox* lox, TextureCache* textures, const std::string& path)
+{
+	// a shipped game might only have the cooked level, then it can't be checked against the source
+	const auto source = read_file_to_string_or_none(path);
+	const auto cooked_path = get_cooked_path(path);
+	if (auto cooked = read_file_to_bytes_or_none(cooked_path))
+	{
+		auto file = CookedReader{*cooked, cooked_level_version};
+		const auto is_current = ! source || file.source_hash == get_source_hash(*source);
+		if (file.is_valid && is_current)
+		{
+			data->tiles.load_from_cooked(&file, textures);
+			spawn_level(lox, data.get(), read_level_source(&file));
+			return;
+		}
+
+		if (file.is_valid)
+		{
+			LOG_WARNING(
+				"{0} was changed after it was cooked to {1}, loading it instead", path, cooked_path
+			);
+		}
+		else
+		{
+			LOG_WARNING(
+				"{0} was cooked by another version, loading {1} instead", cooked_path, path
+			);
+		}
+	}
+
+	// without a source this throws that the file is missing
+	tmx::Map map;
+	load_tmx_map(&map, path, source ? *source : read_file_to_string(path));
+	data->tiles.load_from_map(map, textures);
+	spawn_level(lox, data.get(), get_level_source(map, data->tiles, path));
+}
+
+void cook_level(const std::string& path)
+{
+	const auto source = read_file_to_string(path);
+	tmx::Map map;
+	load_tmx_map(&map, path, source);
+	Map tiles;
+	tiles.load_from_map(map, nullptr);
+
+	auto file = CookedWriter{cooked_level_version, get_source_hash(source)};
+	tiles.write_cooked(&file);
+	write_level_source(&file, get_level_source(map, tiles, path));
+
+	const auto cooked_path = get_cooked_path(path);
+	write_file_from_bytes(cooked_path, file.data);
+	LOG_INFO("Cooked {0} to {1}, {2} bytes", path, cooked_path, file.data.size());
 }
 
 void ScriptLevel::add_actor(std::shared_ptr<lox::Instance> x)
@@ -354,7 +549,7 @@ void ScriptLevel::add_actor(std::shared_ptr<lox::Instance> x)
 	auto actor = lox::get_derived<ScriptActorBase>(x);
 	actor->impl->dispatcher = dispatcher;
 	actor->impl->level = &data->level;
-	data->level.actors.emplace_back(actor->impl);
+	data->level.add_actor(actor->impl);
 }
 
 void ScriptLevel::add_solid(std::shared_ptr<lox::Instance> x)
@@ -363,7 +558,7 @@ void ScriptLevel::add_solid(std::shared_ptr<lox::Instance> x)
 	auto solid = lox::get_derived<ScriptSolidBase>(x);
 	solid->impl->dispatcher = dispatcher;
 	solid->impl->level = &data->level;
-	data->level.solids.emplace_back(solid->impl);
+	data->level.add_solid(solid->impl);
 }
 
 namespace script
@@ -371,7 +566,9 @@ namespace script
 
 void render_level(ScriptLevelData* level, lox::NativeRef<RenderArg> rend)
 {
-	level->tiles.render(*rend->data->layer->batch, rend->data->layer->viewport_aabb_in_worldspace);
+	// the viewport starts at the origin, move it to where the camera looks
+	const auto view = rend->data->layer->viewport_aabb_in_worldspace.translate(rend->data->focus);
+	level->tiles.render(*rend->data->layer->batch, view);
 	level->level.render(rend->data.get(), rend.instance);
 }
 
@@ -425,12 +622,20 @@ void bind_phys_actor(lox::Lox* lox)
 		.add_property<lox::Ti>(
 			"x",
 			[](ScriptActorBase& x) -> lox::Ti { return x.impl->position.x; },
-			[](ScriptActorBase& x, lox::Ti v) { x.impl->position.x = to_int(v); }
+			[](ScriptActorBase& x, lox::Ti v)
+			{
+				x.impl->position.x = to_int(v);
+				x.impl->update_broadphase();
+			}
 		)
 		.add_property<lox::Ti>(
 			"y",
 			[](ScriptActorBase& x) -> lox::Ti { return x.impl->position.y; },
-			[](ScriptActorBase& x, lox::Ti v) { x.impl->position.y = to_int(v); }
+			[](ScriptActorBase& x, lox::Ti v)
+			{
+				x.impl->position.y = to_int(v);
+				x.impl->update_broadphase();
+			}
 		)
 		.add_getter<lox::Ti>(
 			"width", [](ScriptActorBase& x) -> lox::Ti { return x.impl->size.get_width(); }
@@ -446,6 +651,7 @@ void bind_phys_actor(lox::Lox* lox)
 				auto height = to_int(ah.require_int("height"));
 				if(ah.complete()) { return lox::make_nil(); }
 				x.impl->size = Recti{width, height};
+				x.impl->update_broadphase();
 				return lox::make_nil();
 			}
 		)
@@ -459,6 +665,17 @@ void bind_phys_actor(lox::Lox* lox)
 				auto down = to_int(ah.require_int("down"));
 				if(ah.complete()) { return lox::make_nil(); }
 				x.impl->size = Recti{left, down, right, up};
+				x.impl->update_broadphase();
+				return lox::make_nil();
+			}
+		)
+		.add_function(
+			"set_collision_class",
+			[](ScriptActorBase& x, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
+			{
+				auto name = ah.require_string("name");
+				if(ah.complete()) { return lox::make_nil(); }
+				x.impl->collision_class = name;
 				return lox::make_nil();
 			}
 		);
@@ -486,12 +703,20 @@ void bind_phys_solid(lox::Lox* lox)
 		.add_property<lox::Ti>(
 			"x",
 			[](ScriptSolidBase& x) -> lox::Ti { return x.impl->position.x; },
-			[](ScriptSolidBase& x, lox::Ti v) { x.impl->position.x = to_int(v); }
+			[](ScriptSolidBase& x, lox::Ti v)
+			{
+				x.impl->position.x = to_int(v);
+				x.impl->update_broadphase();
+			}
 		)
 		.add_property<lox::Ti>(
 			"y",
 			[](ScriptSolidBase& x) -> lox::Ti { return x.impl->position.y; },
-			[](ScriptSolidBase& x, lox::Ti v) { x.impl->position.y = to_int(v); }
+			[](ScriptSolidBase& x, lox::Ti v)
+			{
+				x.impl->position.y = to_int(v);
+				x.impl->update_broadphase();
+			}
 		)
 		.add_getter<lox::Ti>(
 			"width", [](ScriptSolidBase& x) -> lox::Ti { return x.impl->size.get_width(); }
@@ -507,12 +732,13 @@ void bind_phys_solid(lox::Lox* lox)
 				auto height = to_int(ah.require_int("height"));
 				if(ah.complete()) { return lox::make_nil(); }
 				x.impl->size = Recti{width, height};
+				x.impl->update_broadphase();
 				return lox::make_nil();
 			}
 		);
 }
 
-void bind_phys_level(lox::Lox* lox)
+void bind_phys_level(lox::Lox* lox, TextureCache* texture_cache)
 {
 	auto fyro = lox->in_package("fyro");
 	fyro->define_native_class<ScriptLevel>("Level")
@@ -528,11 +754,12 @@ void bind_phys_level(lox::Lox* lox)
 		)
 		.add_function(
 			"load_tmx",
-			[lox](ScriptLevel& r, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
+			[lox,
+			 texture_cache](ScriptLevel& r, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
 			{
 				auto path = ah.require_string("path");
 				if(ah.complete()) { return lox::make_nil(); }
-				r.load_tmx(lox, path);
+				r.load_tmx(lox, texture_cache, path);
 				return lox::make_nil();
 			}
 		)
@@ -552,6 +779,20 @@ void bind_phys_level(lox::Lox* lox)
 				return lox::make_nil();
 			}
 		)
+		.add_function(
+			"add_collision_handler",
+			[](ScriptLevel& r, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
+			{
+				const auto lhs = ah.require_string("lhs");
+				const auto rhs = ah.require_string("rhs");
+				const auto callback = ah.require_callable("on_collision");
+				if(ah.complete()) { return lox::make_nil(); }
+				LOX_ERROR(lhs.empty() == false, "lhs must be a collision class");
+				LOX_ERROR(rhs.empty() == false, "rhs must be a collision class");
+				r.data->collision_handlers.emplace_back(CollisionHandler{lhs, rhs, callback});
+				return lox::make_nil();
+			}
+		)
 		.add_function(
 			"add_solid",
 			[](ScriptLevel& r, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
@@ -8,12 +8,23 @@ namespace lox
 struct Lox;
 }
 
+/** A script function that is called once per frame for every pair of touching actors with the
+ * collision classes, the actors are passed in the same order as the classes
+ */
+struct CollisionHandler
+{
+	std::string lhs;
+	std::string rhs;
+	std::shared_ptr<lox::Callable> on_collision;
+};
+
 struct ScriptLevelData
 {
 	fyro::Level level;
 	Map tiles;
 
 	std::map<std::string, std::shared_ptr<lox::Callable>> from_tileset;
+	std::vector<CollisionHandler> collision_handlers;
 };
 
 struct ScriptLevel
@@ -21,16 +32,19 @@ struct ScriptLevel
 	std::shared_ptr<ScriptLevelData> data;
 
 	ScriptLevel();
-	void load_tmx(lox::Lox* lox, const std::string& path);
+	void load_tmx(lox::Lox* lox, TextureCache* textures, const std::string& path);
 	void add_actor(std::shared_ptr<lox::Instance> x);
 	void add_solid(std::shared_ptr<lox::Instance> x);
 };
 
+/// write a prebuilt version of the tmx level next to it, load_tmx loads it instead of the tmx file
+void cook_level(const std::string& path);
+
 namespace bind
 {
 
 void bind_phys_actor(lox::Lox* lox);
 void bind_phys_solid(lox::Lox* lox);
-void bind_phys_level(lox::Lox* lox);
+void bind_phys_level(lox::Lox* lox, TextureCache* texture_cache);
 
 }  //  namespace bind
@@ -254,6 +254,51 @@ void bind_render_command(lox::Lox* lox, AnimationsArray* animations)
 				return lox::make_nil();
 			}
 		)
+		.add_function(
+			"sort_sprites",
+			[](RenderArg& r, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
+			{
+				if(ah.complete()) { return lox::make_nil(); }
+
+				auto data = r.data;
+				LOX_ERROR(data, "must be called inside State.render()");
+				LOX_ERROR(data->layer, "need to setup virtual render area first");
+
+				data->layer->start_sorting();
+				return lox::make_nil();
+			}
+		)
+		.add_function(
+			"set_layer",
+			[](RenderArg& r, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
+			{
+				const auto layer = ah.require_int("layer");
+				if(ah.complete()) { return lox::make_nil(); }
+				LOX_ERROR(layer >= 0 && layer <= 255, "layer must be between 0 and 255");
+
+				auto data = r.data;
+				LOX_ERROR(data, "must be called inside State.render()");
+				LOX_ERROR(data->layer, "need to setup virtual render area first");
+
+				data->layer->set_sort_layer(static_cast<u8>(layer));
+				return lox::make_nil();
+			}
+		)
+		.add_function(
+			"set_depth",
+			[](RenderArg& r, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
+			{
+				const auto depth = static_cast<float>(ah.require_float("depth"));
+				if(ah.complete()) { return lox::make_nil(); }
+
+				auto data = r.data;
+				LOX_ERROR(data, "must be called inside State.render()");
+				LOX_ERROR(data->layer, "need to setup virtual render area first");
+
+				data->layer->set_depth(depth);
+				return lox::make_nil();
+			}
+		)
 		.add_function(
 			"rect",
 			[](RenderArg& r, lox::ArgumentHelper& ah) -> std::shared_ptr<lox::Object>
@@ -6,6 +6,21 @@
 
 #include "fyro/collision2.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FYRO_COLLISION_SSE 1
+#include <emmintrin.h>
+#else
+#define FYRO_COLLISION_SSE 0
+#endif
+
+#include "fyro/cint.h"
+#include "fyro/bind.render.h"
+#include "fyro/render/render2.h"
+
 namespace fyro
 {
 
@@ -27,12 +42,923 @@ int Sign(int x)
 	}
 }
 
-void Level::register_collision(Actor*, Actor*)
+std::vector<Recti> merge_rects(const std::vector<Recti>& rects)
 {
+	// split the area into cells along every edge, each cell is either fully covered or empty
+	std::vector<int> xs;
+	std::vector<int> ys;
+	for (const auto& r: rects)
+	{
+		if (r.get_width() <= 0 || r.get_height() <= 0)
+		{
+			continue;
+		}
+		xs.emplace_back(r.left);
+		xs.emplace_back(r.right);
+		ys.emplace_back(r.bottom);
+		ys.emplace_back(r.top);
+	}
+	const auto sort_unique = [](std::vector<int>* v)
+	{
+		std::sort(v->begin(), v->end());
+		v->erase(std::unique(v->begin(), v->end()), v->end());
+	};
+	sort_unique(&xs);
+	sort_unique(&ys);
+	if (xs.size() < 2 || ys.size() < 2)
+	{
+		return {};
+	}
+
+	const auto index_of = [](const std::vector<int>& v, int value)
+	{ return static_cast<std::size_t>(std::lower_bound(v.begin(), v.end(), value) - v.begin()); };
+
+	const auto width = xs.size() - 1;
+	const auto height = ys.size() - 1;
+	std::vector<bool> covered(width * height, false);
+	for (const auto& r: rects)
+	{
+		if (r.get_width() <= 0 || r.get_height() <= 0)
+		{
+			continue;
+		}
+		const auto right = index_of(xs, r.right);
+		const auto top = index_of(ys, r.top);
+		for (auto y = index_of(ys, r.bottom); y < top; y += 1)
+		{
+			for (auto x = index_of(xs, r.left); x < right; x += 1)
+			{
+				covered[y * width + x] = true;
+			}
+		}
+	}
+
+	// grow each rect as far right as possible and then up as long as the whole row is covered,
+	// the covered cells are cleared as they are merged
+	std::vector<Recti> r;
+	for (std::size_t y = 0; y < height; y += 1)
+	{
+		for (std::size_t x = 0; x < width; x += 1)
+		{
+			if (covered[y * width + x] == false)
+			{
+				continue;
+			}
+
+			auto right = x + 1;
+			while (right < width && covered[y * width + right])
+			{
+				right += 1;
+			}
+
+			const auto is_row_covered = [&](std::size_t row)
+			{
+				for (auto cx = x; cx < right; cx += 1)
+				{
+					if (covered[row * width + cx] == false)
+					{
+						return false;
+					}
+				}
+				return true;
+			};
+
+			auto top = y + 1;
+			while (top < height && is_row_covered(top))
+			{
+				top += 1;
+			}
+
+			for (auto cy = y; cy < top; cy += 1)
+			{
+				for (auto cx = x; cx < right; cx += 1)
+				{
+					covered[cy * width + cx] = false;
+				}
+			}
+
+			r.emplace_back(xs[x], ys[y], xs[right], ys[top]);
+		}
+	}
+
+	return r;
+}
+
+namespace
+{
+	int floor_div(int value, int divisor)
+	{
+		const auto d = value / divisor;
+		return (value % divisor != 0 && value < 0) ? d - 1 : d;
+	}
+
+	// the cells of a grid with a fixed size
+	CellRange get_grid_cells(
+		const Recti& rect, const glm::ivec2& cell_size, const glm::ivec2& cell_count
+	)
+	{
+		const auto r = get_cells(rect, cell_size);
+		return CellRange{
+			{std::clamp(r.begin.x, 0, cell_count.x), std::clamp(r.begin.y, 0, cell_count.y)},
+			{std::clamp(r.end.x, 0, cell_count.x), std::clamp(r.end.y, 0, cell_count.y)}
+		};
+	}
+
+	// the actors a moved solid might push or carry, in the order they were added to the level
+	std::vector<Actor*> get_moved_actors(Solid* solid, const ActorList& riding)
+	{
+		auto* level = solid->level;
+		std::vector<ColliderHandle> handles;
+		level->actor_hash.query(solid->get_rect(), &handles);
+		for (auto* actor: riding.actors)
+		{
+			handles.emplace_back(actor->collider);
+		}
+		std::sort(handles.begin(), handles.end());
+		handles.erase(std::unique(handles.begin(), handles.end()), handles.end());
+
+		std::vector<Actor*> r;
+		for (const auto handle: handles)
+		{
+			r.emplace_back(level->actors[handle].get());
+		}
+		return r;
+	}
+
+	u64 get_cell_key(int x, int y)
+	{
+		return (static_cast<u64>(static_cast<u32>(x)) << 32) | static_cast<u32>(y);
+	}
+
+	void remove_from_cells(
+		std::unordered_map<u64, std::vector<ColliderHandle>>* cells,
+		ColliderHandle handle,
+		const CellRange& range
+	)
+	{
+		for (auto y = range.begin.y; y < range.end.y; y += 1)
+		{
+			for (auto x = range.begin.x; x < range.end.x; x += 1)
+			{
+				const auto found = cells->find(get_cell_key(x, y));
+				if (found == cells->end())
+				{
+					continue;
+				}
+				auto& handles = found->second;
+				handles.erase(std::remove(handles.begin(), handles.end(), handle), handles.end());
+				if (handles.empty())
+				{
+					cells->erase(found);
+				}
+			}
+		}
+	}
+
+	// the lanes one at a time, the fallback when the batches can't be tested with sse
+	template<typename Lane>
+	void for_each_lane(std::size_t begin, std::size_t end, Lane lane)
+	{
+		for (auto index = begin; index < end; index += 1)
+		{
+			lane(index);
+		}
+	}
+
+	// run the batch on each full batch of lanes and then the lane on the rest one at a time
+	template<typename Batch, typename Lane>
+	void for_each_batch(std::size_t begin, std::size_t end, Batch batch, Lane lane)
+	{
+		auto index = begin;
+		for (; index + collider_lanes <= end; index += collider_lanes)
+		{
+			batch(index);
+		}
+		for (; index < end; index += 1)
+		{
+			lane(index);
+		}
+	}
+
+	// the overlap test of rect_intersect for a single lane, without branches
+	struct OverlapLane
+	{
+		const i32* left;
+		const i32* bottom;
+		const i32* right;
+		const i32* top;
+		Recti rect;
+
+		OverlapLane(const Recti& r, const ColliderBounds& bounds)
+			: left(bounds.left.data())
+			, bottom(bounds.bottom.data())
+			, right(bounds.right.data())
+			, top(bounds.top.data())
+			, rect(r)
+		{
+		}
+
+		u8 operator()(std::size_t index) const
+		{
+			return static_cast<u8>(
+				(left[index] < rect.right) & (right[index] > rect.left)
+				& (bottom[index] < rect.top) & (top[index] > rect.bottom)
+			);
+		}
+	};
+
+	// get_first_overlap for a single lane, without branches, 0 if it doesn't overlap.
+	// the edges are picked once so every lane does the same math in every direction
+	struct SweepLane
+	{
+		const i32* near;	// the edge of the other rect that the moving rect hits first
+		const i32* far;	 // the edge of the other rect that the moving rect leaves last
+		const i32* low;	 // the edges across the direction
+		const i32* high;
+		int sign;
+		int leading;
+		int trailing;
+		int moving_low;
+		int moving_high;
+		int steps;
+
+		SweepLane(
+			const Recti& moving, const ColliderBounds& bounds, const glm::ivec2& direction, int s
+		)
+			: steps(s)
+		{
+			const auto is_x = direction.x != 0;
+			sign = is_x ? direction.x : direction.y;
+			const auto forward = sign > 0;
+			if (is_x)
+			{
+				near = forward ? bounds.left.data() : bounds.right.data();
+				far = forward ? bounds.right.data() : bounds.left.data();
+				low = bounds.bottom.data();
+				high = bounds.top.data();
+				leading = forward ? moving.right : moving.left;
+				trailing = forward ? moving.left : moving.right;
+				moving_low = moving.bottom;
+				moving_high = moving.top;
+			}
+			else
+			{
+				near = forward ? bounds.bottom.data() : bounds.top.data();
+				far = forward ? bounds.top.data() : bounds.bottom.data();
+				low = bounds.left.data();
+				high = bounds.right.data();
+				leading = forward ? moving.top : moving.bottom;
+				trailing = forward ? moving.bottom : moving.top;
+				moving_low = moving.left;
+				moving_high = moving.right;
+			}
+		}
+
+		i32 operator()(std::size_t index) const
+		{
+			const auto after = sign * (near[index] - leading);
+			const auto before = sign * (far[index] - trailing);
+			const auto first = std::max(1, after + 1);
+			const auto hit = (high[index] > moving_low) & (low[index] < moving_high)
+						   & (first < before) & (first <= steps);
+			return hit ? first : 0;
+		}
+	};
+
+#if FYRO_COLLISION_SSE
+	// a sse register is 4 lanes, a batch is tested as 2 registers
+	constexpr std::size_t sse_lanes = 4;
+	static_assert(collider_lanes == sse_lanes * 2);
+
+	__m128i load_lanes(const i32* source, std::size_t index)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index));
+	}
+
+	// a where the mask is set and b where it isn't
+	__m128i select_lanes(__m128i mask, __m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	// OverlapLane for 4 lanes, all bits are set in the lanes that overlap
+	struct OverlapSse
+	{
+		const i32* left;
+		const i32* bottom;
+		const i32* right;
+		const i32* top;
+		__m128i rect_left;
+		__m128i rect_bottom;
+		__m128i rect_right;
+		__m128i rect_top;
+
+		explicit OverlapSse(const OverlapLane& lane)
+			: left(lane.left)
+			, bottom(lane.bottom)
+			, right(lane.right)
+			, top(lane.top)
+			, rect_left(_mm_set1_epi32(lane.rect.left))
+			, rect_bottom(_mm_set1_epi32(lane.rect.bottom))
+			, rect_right(_mm_set1_epi32(lane.rect.right))
+			, rect_top(_mm_set1_epi32(lane.rect.top))
+		{
+		}
+
+		__m128i operator()(std::size_t index) const
+		{
+			const auto x = _mm_and_si128(
+				_mm_cmplt_epi32(load_lanes(left, index), rect_right),
+				_mm_cmpgt_epi32(load_lanes(right, index), rect_left)
+			);
+			const auto y = _mm_and_si128(
+				_mm_cmplt_epi32(load_lanes(bottom, index), rect_top),
+				_mm_cmpgt_epi32(load_lanes(top, index), rect_bottom)
+			);
+			return _mm_and_si128(x, y);
+		}
+	};
+
+	// SweepLane for 4 lanes, sse2 has no 32 bit multiply, min or max so the sign is applied by
+	// negating and the max is a select
+	struct SweepSse
+	{
+		const SweepLane& lane;
+		__m128i negate;	 // all bits set if the sign is negative
+		__m128i leading;
+		__m128i trailing;
+		__m128i moving_low;
+		__m128i moving_high;
+		__m128i steps;
+		__m128i one;
+
+		explicit SweepSse(const SweepLane& l)
+			: lane(l)
+			, negate(_mm_set1_epi32(l.sign < 0 ? -1 : 0))
+			, leading(_mm_set1_epi32(l.leading))
+			, trailing(_mm_set1_epi32(l.trailing))
+			, moving_low(_mm_set1_epi32(l.moving_low))
+			, moving_high(_mm_set1_epi32(l.moving_high))
+			, steps(_mm_set1_epi32(l.steps))
+			, one(_mm_set1_epi32(1))
+		{
+		}
+
+		__m128i apply_sign(__m128i v) const
+		{
+			return _mm_sub_epi32(_mm_xor_si128(v, negate), negate);
+		}
+
+		// the first step in the lanes that hit, 0 in the rest
+		__m128i operator()(std::size_t index) const
+		{
+			const auto after = apply_sign(_mm_sub_epi32(load_lanes(lane.near, index), leading));
+			const auto before = apply_sign(_mm_sub_epi32(load_lanes(lane.far, index), trailing));
+			const auto next = _mm_add_epi32(after, one);
+			const auto first = select_lanes(_mm_cmpgt_epi32(next, one), next, one);
+			const auto across = _mm_and_si128(
+				_mm_cmpgt_epi32(load_lanes(lane.high, index), moving_low),
+				_mm_cmplt_epi32(load_lanes(lane.low, index), moving_high)
+			);
+			const auto in_range
+				= _mm_andnot_si128(_mm_cmpgt_epi32(first, steps), _mm_cmplt_epi32(first, before));
+			return _mm_and_si128(_mm_and_si128(across, in_range), first);
+		}
+	};
+#endif
+}  //  namespace
+
+std::size_t ColliderBounds::size() const
+{
+	return left.size();
+}
+
+void ColliderBounds::clear()
+{
+	left.clear();
+	bottom.clear();
+	right.clear();
+	top.clear();
+}
+
+void ColliderBounds::resize(std::size_t count)
+{
+	left.resize(count, 0);
+	bottom.resize(count, 0);
+	right.resize(count, 0);
+	top.resize(count, 0);
+}
+
+void ColliderBounds::set(std::size_t index, const Recti& rect)
+{
+	left[index] = rect.left;
+	bottom[index] = rect.bottom;
+	right[index] = rect.right;
+	top[index] = rect.top;
+}
+
+Recti ColliderBounds::get(std::size_t index) const
+{
+	return Recti{left[index], bottom[index], right[index], top[index]};
+}
+
+void ColliderBounds::gather(
+	const ColliderBounds& source, const std::vector<ColliderHandle>& handles
+)
+{
+	resize(handles.size());
+	for (std::size_t index = 0; index < handles.size(); index += 1)
+	{
+		const auto handle = handles[index];
+		left[index] = source.left[handle];
+		bottom[index] = source.bottom[handle];
+		right[index] = source.right[handle];
+		top[index] = source.top[handle];
+	}
+}
+
+void get_overlaps(
+	const Recti& rect, const ColliderBounds& bounds, std::size_t begin, std::size_t end, u8* result
+)
+{
+	const auto lane = OverlapLane{rect, bounds};
+	const auto single = [&](std::size_t index) { result[index - begin] = lane(index); };
+#if FYRO_COLLISION_SSE
+	const auto batch = OverlapSse{lane};
+	const auto one = _mm_set1_epi8(1);
+	for_each_batch(
+		begin,
+		end,
+		[&](std::size_t index)
+		{
+			// narrow the 8 masks to bytes and keep the lowest bit
+			const auto words = _mm_packs_epi32(batch(index), batch(index + sse_lanes));
+			const auto bytes = _mm_and_si128(_mm_packs_epi16(words, words), one);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(result + (index - begin)), bytes);
+		},
+		single
+	);
+#else
+	for_each_lane(begin, end, single);
+#endif
+}
+
+void get_first_overlaps(
+	const Recti& moving,
+	const ColliderBounds& bounds,
+	std::size_t begin,
+	std::size_t end,
+	const glm::ivec2& direction,
+	int steps,
+	i32* result
+)
+{
+	const auto lane = SweepLane{moving, bounds, direction, steps};
+	const auto single = [&](std::size_t index) { result[index - begin] = lane(index); };
+#if FYRO_COLLISION_SSE
+	const auto batch = SweepSse{lane};
+	for_each_batch(
+		begin,
+		end,
+		[&](std::size_t index)
+		{
+			auto* target = reinterpret_cast<__m128i*>(result + (index - begin));
+			_mm_storeu_si128(target, batch(index));
+			_mm_storeu_si128(target + 1, batch(index + sse_lanes));
+		},
+		single
+	);
+#else
+	for_each_lane(begin, end, single);
+#endif
+}
+
+bool has_overlap(
+	const Recti& rect, const ColliderBounds& bounds, std::size_t begin, std::size_t end
+)
+{
+	const auto lane = OverlapLane{rect, bounds};
+	u8 any = 0;
+	const auto single = [&](std::size_t index) { any = static_cast<u8>(any | lane(index)); };
+#if FYRO_COLLISION_SSE
+	const auto batch = OverlapSse{lane};
+	auto any_lane = _mm_setzero_si128();
+	for_each_batch(
+		begin,
+		end,
+		[&](std::size_t index)
+		{
+			any_lane = _mm_or_si128(any_lane, batch(index));
+			any_lane = _mm_or_si128(any_lane, batch(index + sse_lanes));
+		},
+		single
+	);
+	return any != 0 || _mm_movemask_epi8(any_lane) != 0;
+#else
+	for_each_lane(begin, end, single);
+	return any != 0;
+#endif
+}
+
+std::optional<int> get_first_overlap(
+	const Recti& moving,
+	const ColliderBounds& bounds,
+	std::size_t begin,
+	std::size_t end,
+	const glm::ivec2& direction,
+	int steps
+)
+{
+	constexpr auto none = std::numeric_limits<i32>::max();
+	const auto lane = SweepLane{moving, bounds, direction, steps};
+	i32 first = none;
+	const auto single = [&](std::size_t index)
+	{
+		const auto step = lane(index);
+		first = std::min(first, step != 0 ? step : none);
+	};
+#if FYRO_COLLISION_SSE
+	const auto batch = SweepSse{lane};
+	const auto zero = _mm_setzero_si128();
+	const auto none_lane = _mm_set1_epi32(none);
+	auto first_lane = none_lane;
+	const auto keep_first = [&](__m128i step)
+	{
+		const auto candidate = select_lanes(_mm_cmpeq_epi32(step, zero), none_lane, step);
+		first_lane
+			= select_lanes(_mm_cmplt_epi32(candidate, first_lane), candidate, first_lane);
+	};
+	for_each_batch(
+		begin,
+		end,
+		[&](std::size_t index)
+		{
+			keep_first(batch(index));
+			keep_first(batch(index + sse_lanes));
+		},
+		single
+	);
+
+	i32 lanes[sse_lanes];
+	std::memcpy(lanes, &first_lane, sizeof(lanes));
+	for (const auto step: lanes)
+	{
+		first = std::min(first, step);
+	}
+#else
+	for_each_lane(begin, end, single);
+#endif
+
+	if (first == none)
+	{
+		return std::nullopt;
+	}
+	return first;
+}
+
+SpatialHash::SpatialHash(int size)
+	: cell_size(size)
+{
+}
+
+void SpatialHash::place(ColliderHandle handle, const Recti& rect)
+{
+	const auto range = get_cells(rect, {cell_size, cell_size});
+	if (handle >= placed.size())
+	{
+		placed.resize(handle + 1);
+	}
+
+	auto& current = placed[handle];
+	if (current)
+	{
+		// most moves are a pixel and stay in the same cells
+		if (*current == range)
+		{
+			return;
+		}
+		remove_from_cells(&cells, handle, *current);
+	}
+	current = range;
+
+	for (auto y = range.begin.y; y < range.end.y; y += 1)
+	{
+		for (auto x = range.begin.x; x < range.end.x; x += 1)
+		{
+			cells[get_cell_key(x, y)].emplace_back(handle);
+		}
+	}
+}
+
+void SpatialHash::remove(ColliderHandle handle)
+{
+	if (handle < placed.size() && placed[handle])
+	{
+		remove_from_cells(&cells, handle, *placed[handle]);
+		placed[handle].reset();
+	}
+}
+
+void SpatialHash::query(const Recti& rect, std::vector<ColliderHandle>* result) const
+{
+	result->clear();
+	const auto range = get_cells(rect, {cell_size, cell_size});
+	for (auto y = range.begin.y; y < range.end.y; y += 1)
+	{
+		for (auto x = range.begin.x; x < range.end.x; x += 1)
+		{
+			if (const auto found = cells.find(get_cell_key(x, y)); found != cells.end())
+			{
+				result->insert(result->end(), found->second.begin(), found->second.end());
+			}
+		}
+	}
+
+	// colliders that span several cells are found more than once
+	std::sort(result->begin(), result->end());
+	if (range.end.x - range.begin.x > 1 || range.end.y - range.begin.y > 1)
+	{
+		result->erase(std::unique(result->begin(), result->end()), result->end());
+	}
+}
+
+bool CellRange::operator==(const CellRange& rhs) const
+{
+	return begin == rhs.begin && end == rhs.end;
+}
+
+std::optional<int> get_first_overlap(
+	const Recti& moving, const Recti& other, const glm::ivec2& direction, int steps
+)
+{
+	// the moved rect overlaps while the step is inside the open range (after, before)
+	// and it never overlaps if it isn't overlapping the other rect across the direction
+	int after = 0;
+	int before = 0;
+	if (direction.x != 0)
+	{
+		if (other.top <= moving.bottom || other.bottom >= moving.top)
+		{
+			return std::nullopt;
+		}
+		after = direction.x > 0 ? other.left - moving.right : moving.left - other.right;
+		before = direction.x > 0 ? other.right - moving.left : moving.right - other.left;
+	}
+	else
+	{
+		if (other.right <= moving.left || other.left >= moving.right)
+		{
+			return std::nullopt;
+		}
+		after = direction.y > 0 ? other.bottom - moving.top : moving.bottom - other.top;
+		before = direction.y > 0 ? other.top - moving.bottom : moving.top - other.bottom;
+	}
+
+	const auto first = std::max(1, after + 1);
+	if (first < before && first <= steps)
+	{
+		return first;
+	}
+	return std::nullopt;
+}
+
+Recti get_swept_rect(const Recti& moving, const glm::ivec2& direction, int steps)
+{
+	const auto first = moving.translate(direction);
+	const auto last = moving.translate(direction * steps);
+	return Recti{
+		std::min(first.left, last.left),
+		std::min(first.bottom, last.bottom),
+		std::max(first.right, last.right),
+		std::max(first.top, last.top)
+	};
+}
+
+namespace
+{
+	void keep_first(std::optional<int>* first, std::optional<int> step)
+	{
+		if (step && (! *first || *step < **first))
+		{
+			*first = step;
+		}
+	}
+}  //  namespace
+
+CellRange get_cells(const Recti& rect, const glm::ivec2& cell_size)
+{
+	// the right and top edges are outside of the rect, except for empty rects
+	const auto right = std::max(rect.left, rect.right - 1);
+	const auto top = std::max(rect.bottom, rect.top - 1);
+	return CellRange{
+		{floor_div(rect.left, cell_size.x), floor_div(rect.bottom, cell_size.y)},
+		{floor_div(right, cell_size.x) + 1, floor_div(top, cell_size.y) + 1}
+	};
+}
+
+TileGridCollider::TileGridCollider(
+	const glm::ivec2& size, const glm::ivec2& count, const std::vector<Recti>& solids
+)
+	: cell_size(size)
+	, cell_count(count)
+{
+	ASSERT(cell_size.x > 0 && cell_size.y > 0);
+	const auto cells = Cint_to_sizet(cell_count.x * cell_count.y);
+
+	// count the rects in each cell and then place them, cell by cell
+	cell_start.resize(cells + 1, 0);
+	for (const auto& rect: solids)
+	{
+		const auto range = get_grid_cells(rect, cell_size, cell_count);
+		for (auto y = range.begin.y; y < range.end.y; y += 1)
+		{
+			for (auto x = range.begin.x; x < range.end.x; x += 1)
+			{
+				cell_start[Cint_to_sizet(y * cell_count.x + x) + 1] += 1;
+			}
+		}
+	}
+	for (std::size_t cell = 0; cell < cells; cell += 1)
+	{
+		cell_start[cell + 1] += cell_start[cell];
+	}
+
+	rects.resize(cell_start[cells]);
+	auto next = cell_start;
+	for (const auto& rect: solids)
+	{
+		const auto range = get_grid_cells(rect, cell_size, cell_count);
+		for (auto y = range.begin.y; y < range.end.y; y += 1)
+		{
+			for (auto x = range.begin.x; x < range.end.x; x += 1)
+			{
+				rects.set(next[Cint_to_sizet(y * cell_count.x + x)]++, rect);
+			}
+		}
+	}
+}
+
+bool TileGridCollider::collides(const Recti& rect) const
+{
+	const auto range = get_grid_cells(rect, cell_size, cell_count);
+	for (auto y = range.begin.y; y < range.end.y; y += 1)
+	{
+		const auto row = Cint_to_sizet(y * cell_count.x);
+		const auto begin = cell_start[row + Cint_to_sizet(range.begin.x)];
+		const auto end = cell_start[row + Cint_to_sizet(range.end.x)];
+		if (has_overlap(rect, rects, begin, end))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+std::optional<int> TileGridCollider::sweep(
+	const Recti& rect, const glm::ivec2& direction, int steps
+) const
+{
+	std::optional<int> first;
+	const auto swept = get_swept_rect(rect, direction, steps);
+	const auto range = get_grid_cells(swept, cell_size, cell_count);
+	for (auto y = range.begin.y; y < range.end.y; y += 1)
+	{
+		const auto row = Cint_to_sizet(y * cell_count.x);
+		const auto begin = cell_start[row + Cint_to_sizet(range.begin.x)];
+		const auto end = cell_start[row + Cint_to_sizet(range.end.x)];
+		keep_first(&first, get_first_overlap(rect, rects, begin, end, direction, steps));
+	}
+	return first;
+}
+
+void Level::add_actor(std::shared_ptr<Actor> actor)
+{
+	actor->collider = static_cast<ColliderHandle>(actors.size());
+	actor_bounds.resize(actors.size() + 1);
+	place_actor(*actor);
+	actors.emplace_back(std::move(actor));
+}
+
+void Level::add_solid(std::shared_ptr<Solid> solid)
+{
+	solid->collider = static_cast<ColliderHandle>(solids.size());
+	solid_bounds.resize(solids.size() + 1);
+	place_solid(*solid);
+	solids.emplace_back(std::move(solid));
+}
+
+void Level::place_actor(const Actor& actor)
+{
+	const auto rect = actor.get_rect();
+	actor_bounds.set(actor.collider, rect);
+	actor_hash.place(actor.collider, rect);
+}
+
+void Level::place_solid(const Solid& solid)
+{
+	const auto rect = solid.get_rect();
+	solid_bounds.set(solid.collider, rect);
+	solid_hash.place(solid.collider, rect);
+}
+
+void Level::update_broadphase()
+{
+	for (auto& actor: actors)
+	{
+		place_actor(*actor);
+	}
+
+	for (auto& solid: solids)
+	{
+		place_solid(*solid);
+	}
+}
+
+void Level::query_actors(const Recti& rect)
+{
+	actor_hash.query(rect, &query);
+	candidates.gather(actor_bounds, query);
+}
+
+void Level::query_solids(const Recti& rect)
+{
+	solid_hash.query(rect, &query);
+	query.erase(
+		std::remove_if(
+			query.begin(),
+			query.end(),
+			[this](ColliderHandle handle) { return solids[handle]->is_collidable == false; }
+		),
+		query.end()
+	);
+	candidates.gather(solid_bounds, query);
+}
+
+bool Contact::operator==(const Contact& other) const
+{
+	return lhs == other.lhs && rhs == other.rhs;
+}
+
+bool Contact::operator<(const Contact& other) const
+{
+	return lhs != other.lhs ? lhs < other.lhs : rhs < other.rhs;
+}
+
+void Level::register_collision(Actor* lhs, Actor* rhs)
+{
+	if (lhs == rhs)
+	{
+		return;
+	}
+	contacts.emplace_back(Contact{
+		std::min(lhs->collider, rhs->collider), std::max(lhs->collider, rhs->collider)
+	});
+}
+
+void Level::find_contacts()
+{
+	for (const auto& actor: actors)
+	{
+		const auto self = actor_bounds.get(actor->collider);
+		query_actors(self);
+		const auto found = query.size();
+		overlaps.resize(found);
+		get_overlaps(self, candidates, 0, found, overlaps.data());
+
+		// every pair is found from both actors, only keep it from the first one
+		for (std::size_t index = 0; index < found; index += 1)
+		{
+			if (overlaps[index] != 0 && query[index] > actor->collider)
+			{
+				contacts.emplace_back(Contact{actor->collider, query[index]});
+			}
+		}
+	}
+}
+
+void Level::dispatch_contacts()
+{
+	// a actor might touch the same actor many times in a frame, like when it moves several times
+	std::vector<Contact> frame;
+	frame.swap(contacts);
+	std::sort(frame.begin(), frame.end());
+	frame.erase(std::unique(frame.begin(), frame.end()), frame.end());
+
+	if (! on_contact)
+	{
+		return;
+	}
+
+	for (const auto& contact: frame)
+	{
+		on_contact(actors[contact.lhs].get(), actors[contact.rhs].get());
+	}
 }
 
 void Level::update(float dt)
 {
+	update_broadphase();
+
 	for (auto& actor: actors)
 	{
 		actor->update(dt);
@@ -42,10 +968,15 @@ void Level::update(float dt)
 	{
 		solid->update(dt);
 	}
+
+	find_contacts();
+	dispatch_contacts();
 }
 
 void Level::render(RenderData* data, std::shared_ptr<lox::Object> arg)
 {
+	const auto timer = render::ScopedTimer{&data->rc.render->profiler, "Level::render"};
+
 	for (auto& solid: solids)
 	{
 		solid->render(data, arg);
@@ -64,7 +995,12 @@ void ActorList::add(const std::shared_ptr<Actor>& actor)
 
 bool ActorList::has_actor(const std::shared_ptr<Actor>& a) const
 {
-	return actors.find(a.get()) != actors.end();
+	return has_actor(a.get());
+}
+
+bool ActorList::has_actor(Actor* a) const
+{
+	return actors.find(a) != actors.end();
 }
 
 void no_collision_reaction()
@@ -111,32 +1047,59 @@ bool Actor::collide_at(const glm::ivec2& new_position)
 {
 	const auto self = get_rect(new_position);
 
-	for (auto& actor: level->actors)
+	level->query_actors(self);
+	const auto found = level->query.size();
+	level->overlaps.resize(found);
+	get_overlaps(self, level->candidates, 0, found, level->overlaps.data());
+	for (std::size_t index = 0; index < found; index += 1)
 	{
-		if (actor.get() == this)
+		const auto handle = level->query[index];
+		if (level->overlaps[index] != 0 && handle != collider)
 		{
-			continue;
-		}
-		if (rect_intersect(self, actor->get_rect()))
-		{
-			level->register_collision(this, actor.get());
+			level->register_collision(this, level->actors[handle].get());
 		}
 	}
 
-	for (auto& solid: level->solids)
+	if (level->tiles.collides(self))
 	{
-		if (solid->is_collidable == false)
-		{
-			continue;
-		}
+		return true;
+	}
+
+	level->query_solids(self);
+	return has_overlap(self, level->candidates, 0, level->candidates.size());
+}
+
+std::optional<int> Actor::sweep(const glm::ivec2& direction, int steps)
+{
+	const auto self = get_rect();
+	const auto swept = get_swept_rect(self, direction, steps);
 
-		if (rect_intersect(self, solid->get_rect()))
+	std::optional<int> blocked = level->tiles.sweep(self, direction, steps);
+
+	level->query_solids(swept);
+	keep_first(
+		&blocked,
+		get_first_overlap(self, level->candidates, 0, level->candidates.size(), direction, steps)
+	);
+
+	// the actors are only touched up to and including the blocked step
+	const auto last_step = blocked.value_or(steps);
+	level->query_actors(swept);
+	const auto found = level->query.size();
+	level->first_steps.resize(found);
+	get_first_overlaps(
+		self, level->candidates, 0, found, direction, last_step, level->first_steps.data()
+	);
+	for (std::size_t index = 0; index < found; index += 1)
+	{
+		const auto handle = level->query[index];
+		if (level->first_steps[index] != 0 && handle != collider)
 		{
-			return true;
+			level->register_collision(this, level->actors[handle].get());
 		}
 	}
 
-	return false;
+	return blocked;
 }
 
 bool Actor::move_x(float dx, CollisionReaction on_collision)
@@ -169,61 +1132,85 @@ bool Actor::move_y(float dy, CollisionReaction on_collision)
 	}
 }
 
+// move up to the pixel before the first collision in a single sweep
 bool Actor::please_move_x(int dx, CollisionReaction on_collision)
 {
-	const int sign = Sign(dx);
-	int steps_to_move = dx;
-	while (steps_to_move != 0)
+	if (dx == 0)
 	{
-		if (false == collide_at(position + glm::ivec2(sign, 0)))
-		{
-			position.x += sign;
-			steps_to_move -= sign;
-		}
-		else
-		{
-			on_collision();
-			return true;
-		}
+		return false;
 	}
 
+	const int sign = Sign(dx);
+	const auto blocked = sweep(glm::ivec2(sign, 0), std::abs(dx));
+	position.x += sign * (blocked ? *blocked - 1 : std::abs(dx));
+	update_broadphase();
+
+	if (blocked)
+	{
+		on_collision();
+		return true;
+	}
 	return false;
 }
 
 bool Actor::please_move_y(int dy, CollisionReaction on_collision)
 {
-	const int sign = Sign(dy);
-	int steps_to_move = dy;
-	while (steps_to_move != 0)
+	if (dy == 0)
 	{
-		if (false == collide_at(position + glm::ivec2(0, sign)))
-		{
-			position.y += sign;
-			steps_to_move -= sign;
-		}
-		else
-		{
-			on_collision();
-			return true;
-		}
+		return false;
 	}
 
+	const int sign = Sign(dy);
+	const auto blocked = sweep(glm::ivec2(0, sign), std::abs(dy));
+	position.y += sign * (blocked ? *blocked - 1 : std::abs(dy));
+	update_broadphase();
+
+	if (blocked)
+	{
+		on_collision();
+		return true;
+	}
 	return false;
 }
 
+void Actor::update_broadphase()
+{
+	if (level != nullptr)
+	{
+		level->place_actor(*this);
+	}
+}
+
 ActorList Solid::get_all_riding_actors()
 {
+	// a riding actor is usually right above the solid, a actor that is a pixel away might also
+	// count as riding, like when grabbing a ledge
+	const auto rect = get_rect();
+	std::vector<ColliderHandle> nearby;
+	level->actor_hash.query(
+		Recti{rect.left - 1, rect.bottom - 1, rect.right + 1, rect.top + 1}, &nearby
+	);
+
 	ActorList r;
-	for (auto& actor: level->actors)
+	for (const auto handle: nearby)
 	{
+		auto* actor = level->actors[handle].get();
 		if (actor->is_riding_solid(this))
 		{
-			r.add(actor);
+			r.actors.insert(actor);
 		}
 	}
 	return r;
 }
 
+void Solid::update_broadphase()
+{
+	if (level != nullptr)
+	{
+		level->place_solid(*this);
+	}
+}
+
 bool Solid::is_overlapping(const std::shared_ptr<Actor>& actor)
 {
 	return rect_intersect(get_rect(), actor->get_rect());
@@ -238,7 +1225,7 @@ void Solid::Move(float x, float y)
 
 	if (dx != 0 || dy != 0)
 	{
-		// Loop through every Actor in the Level, add it to a list if actor.is_riding_solid(this) is true
+		// Loop through the Actors near the Solid, add it to a list if actor.is_riding_solid(this)
 		// It’s important we do this before we actually move, because the movement could put us out of range for the is_riding_solid checks.
 		const auto riding = get_all_riding_actors();
 
@@ -267,11 +1254,12 @@ void Solid::Move(float x, float y)
 void Solid::please_move_x(int dx, const ActorList& riding)
 {
 	position.x += dx;
+	update_broadphase();
 	if (dx > 0)
 	{
-		for (auto& actor: level->actors)
+		for (auto* actor: get_moved_actors(this, riding))
 		{
-			if (is_overlapping(actor))
+			if (rect_intersect(get_rect(), actor->get_rect()))
 			{
 				// push
 				actor->please_move_x(
@@ -287,9 +1275,9 @@ void Solid::please_move_x(int dx, const ActorList& riding)
 	}
 	else
 	{
-		for (auto& actor: level->actors)
+		for (auto* actor: get_moved_actors(this, riding))
 		{
-			if (is_overlapping(actor))
+			if (rect_intersect(get_rect(), actor->get_rect()))
 			{
 				// push
 				actor->please_move_x(
@@ -308,11 +1296,12 @@ void Solid::please_move_x(int dx, const ActorList& riding)
 void Solid::please_move_y(int dy, const ActorList& riding)
 {
 	position.y += dy;
+	update_broadphase();
 	if (dy > 0)
 	{
-		for (auto& actor: level->actors)
+		for (auto* actor: get_moved_actors(this, riding))
 		{
-			if (is_overlapping(actor))
+			if (rect_intersect(get_rect(), actor->get_rect()))
 			{
 				// push
 				actor->please_move_y(
@@ -328,9 +1317,9 @@ void Solid::please_move_y(int dy, const ActorList& riding)
 	}
 	else
 	{
-		for (auto& actor: level->actors)
+		for (auto* actor: get_moved_actors(this, riding))
 		{
-			if (is_overlapping(actor))
+			if (rect_intersect(get_rect(), actor->get_rect()))
 			{
 				// push
 				actor->please_move_y(
@@ -5,8 +5,12 @@
 #include <memory>
 #include <cmath>
 #include <set>
+#include <optional>
+#include <unordered_map>
+#include <algorithm>
 
 #include "fyro/rect.h"
+#include "fyro/types.h"
 #include "lox/object.h"
 
 struct RenderData;
@@ -25,20 +29,203 @@ based on https://maddythorson.medium.com/celeste-and-towerfall-physics-d24bd2ae0
   * Solids do not interact with other Solids
 */
 
-// todo(Gustav): test
-// todo(Gustav): don't iterate all "object", compute aabb, get a subsection and iterate that
-
 
 struct Actor;
 struct Solid;
 
-struct Level
+/// merge touching and overlapping rects into maximal rects that cover exactly the same area,
+/// greedy row by row so a solid platform of tiles turns into a single rect
+std::vector<Recti> merge_rects(const std::vector<Recti>& rects);
+
+/** The cells of a grid that a rect covers, the end is exclusive */
+struct CellRange
+{
+	glm::ivec2 begin;
+	glm::ivec2 end;
+
+	bool operator==(const CellRange& rhs) const;
+};
+
+/// the cells a rect covers in a grid that starts at the origin and goes on forever
+CellRange get_cells(const Recti& rect, const glm::ivec2& cell_size);
+
+/// the first of the steps, counted from 1, where the moving rect overlaps the other rect when it
+/// moves a pixel at a time in the direction, none if it doesn't overlap within the steps
+std::optional<int> get_first_overlap(
+	const Recti& moving, const Recti& other, const glm::ivec2& direction, int steps
+);
+
+/// the rect that covers all the steps of a move, not including where it starts
+Recti get_swept_rect(const Recti& moving, const glm::ivec2& direction, int steps);
+
+/** Refers to the bounds of a actor or solid, the same as the index in the level */
+using ColliderHandle = u32;
+
+/// the overlap tests run on this many rects at a time
+constexpr std::size_t collider_lanes = 8;
+
+/** The bounds of colliders as a structure of arrays so the overlap tests can test a batch of
+ * rects at once instead of one rect at a time.
+ */
+struct ColliderBounds
 {
-	std::vector<std::shared_ptr<Actor>> actors;
-	std::vector<std::shared_ptr<Solid>> solids;
+	std::vector<i32> left;
+	std::vector<i32> bottom;
+	std::vector<i32> right;
+	std::vector<i32> top;
+
+	std::size_t size() const;
+	void clear();
+	void resize(std::size_t count);
+
+	void set(std::size_t index, const Recti& rect);
+	Recti get(std::size_t index) const;
 
+	/// replace the bounds with the bounds of the handles, in the same order
+	void gather(const ColliderBounds& source, const std::vector<ColliderHandle>& handles);
+};
+
+/// for each of the bounds in [begin, end) set the result to 1 if it overlaps the rect, like
+/// rect_intersect, and 0 if it doesn't, the first result is for the bounds at begin
+void get_overlaps(
+	const Recti& rect, const ColliderBounds& bounds, std::size_t begin, std::size_t end, u8* result
+);
+
+/// for each of the bounds in [begin, end) set the result to the step get_first_overlap returns,
+/// or 0 if it doesn't overlap within the steps
+void get_first_overlaps(
+	const Recti& moving,
+	const ColliderBounds& bounds,
+	std::size_t begin,
+	std::size_t end,
+	const glm::ivec2& direction,
+	int steps,
+	i32* result
+);
+
+/// true if the rect overlaps any of the bounds in [begin, end)
+bool has_overlap(
+	const Recti& rect, const ColliderBounds& bounds, std::size_t begin, std::size_t end
+);
+
+/// the first step that overlaps any of the bounds in [begin, end)
+std::optional<int> get_first_overlap(
+	const Recti& moving,
+	const ColliderBounds& bounds,
+	std::size_t begin,
+	std::size_t end,
+	const glm::ivec2& direction,
+	int steps
+);
+
+/** Buckets colliders by the cells of a uniform grid that they overlap, a query only looks at the
+ * cells the rect covers. A collider stays in the cells it was placed in until it is placed again,
+ * so it needs to be placed again when the position or size changes.
+ */
+struct SpatialHash
+{
+	int cell_size;
+	std::unordered_map<u64, std::vector<ColliderHandle>> cells;
+	std::vector<std::optional<CellRange>> placed;	 // by handle, none if not placed
+
+	explicit SpatialHash(int size = 64);
+
+	/// add the collider or move it to the cells the rect covers
+	void place(ColliderHandle handle, const Recti& rect);
+
+	void remove(ColliderHandle handle);
+
+	/// the colliders in the cells the rect covers sorted by handle, they might not overlap the rect
+	void query(const Recti& rect, std::vector<ColliderHandle>* result) const;
+};
+
+/** Static level geometry, like the collisions of a tile map, stored per cell of a grid that
+ * starts at the origin. A query only tests the cells the rect covers so it doesn't depend on the
+ * size of the map.
+ */
+struct TileGridCollider
+{
+	glm::ivec2 cell_size = {1, 1};
+	glm::ivec2 cell_count = {0, 0};
+
+	// the rects of cell i are rects[cell_start[i]] up to rects[cell_start[i+1]], the cells of a
+	// row are next to each other so a row of cells is tested as a single range
+	std::vector<u32> cell_start;
+	ColliderBounds rects;
+
+	TileGridCollider() = default;
+
+	/// a rect is added to every cell it overlaps, the parts outside of the grid are ignored
+	TileGridCollider(
+		const glm::ivec2& cell_size, const glm::ivec2& cell_count, const std::vector<Recti>& rects
+	);
+
+	/// true if the rect overlaps any of the solid rects
+	bool collides(const Recti& rect) const;
+
+	/// the first step a rect moving in the direction overlaps any of the solid rects
+	std::optional<int> sweep(const Recti& rect, const glm::ivec2& direction, int steps) const;
+};
+
+/** Two actors that touched, lhs is the actor that was added to the level first */
+struct Contact
+{
+	ColliderHandle lhs;
+	ColliderHandle rhs;
+
+	bool operator==(const Contact& other) const;
+	bool operator<(const Contact& other) const;
+};
+
+using ContactReaction = std::function<void(Actor* lhs, Actor* rhs)>;
+
+struct Level
+{
+	std::vector<std::shared_ptr<Actor>> actors;	 // the handle of a actor is the index
+	std::vector<std::shared_ptr<Solid>> solids;	 // the handle of a solid is the index
+	TileGridCollider tiles;	 // the static geometry of the level
+
+	// the bounds and the broadphase of the actors and solids, kept up to date by the move functions
+	ColliderBounds actor_bounds;
+	ColliderBounds solid_bounds;
+	SpatialHash actor_hash;
+	SpatialHash solid_hash;
+
+	// reused between queries to avoid allocations
+	std::vector<ColliderHandle> query;
+	ColliderBounds candidates;
+	std::vector<u8> overlaps;
+	std::vector<i32> first_steps;
+
+	void add_actor(std::shared_ptr<Actor> actor);
+	void add_solid(std::shared_ptr<Solid> solid);
+
+	/// store the current bounds of the actor or solid
+	void place_actor(const Actor& actor);
+	void place_solid(const Solid& solid);
+
+	/// place every actor and solid again, catches positions that were changed directly
+	void update_broadphase();
+
+	/// set the query to the actors or the collidable solids the rect might overlap and gather
+	/// their bounds to the candidates
+	void query_actors(const Recti& rect);
+	void query_solids(const Recti& rect);
+
+	// the actors that touched this frame, sent to on_contact once per pair at the end of update
+	std::vector<Contact> contacts;
+	ContactReaction on_contact;	 // may be empty
+
+	/// remember that the actors touched, a pair is only sent once per frame
 	void register_collision(Actor* lhs, Actor* rhs);
 
+	/// register every pair of actors that overlap now
+	void find_contacts();
+
+	/// send the contacts of this frame to on_contact and clear them, the contacts registered by
+	/// on_contact are sent the next frame
+	void dispatch_contacts();
+
 	void update(float dt);
 	void render(RenderData* data, std::shared_ptr<lox::Object> arg);
 };
@@ -49,6 +236,7 @@ struct ActorList
 
 	void add(const std::shared_ptr<Actor>& actor);
 	bool has_actor(const std::shared_ptr<Actor>& a) const;
+	bool has_actor(Actor* a) const;
 };
 
 using CollisionReaction = std::function<void()>;
@@ -60,6 +248,7 @@ struct Aabb
 
 	glm::ivec2 position;
 	Recti size;
+	ColliderHandle collider = 0;	// set when added to a level
 
 	Recti get_rect(const glm::ivec2& new_position) const;
 	Recti get_rect() const;
@@ -83,6 +272,13 @@ struct Actor : Aabb
 	// true = solid, false = "empty"
 	bool collide_at(const glm::ivec2& new_position);
 
+	/// the first step that collides when moving a pixel at a time in the direction, gives the same
+	/// result as calling collide_at for each step, the actors passed on the way are registered once
+	std::optional<int> sweep(const glm::ivec2& direction, int steps);
+
+	/// call when the position or size was changed without the move functions
+	void update_broadphase();
+
 	virtual void update(float dt) = 0;
 	virtual void render(RenderData* data, std::shared_ptr<lox::Object> arg) = 0;
 
@@ -117,8 +313,12 @@ struct Solid : Aabb
 	virtual void update(float dt) = 0;
 	virtual void render(RenderData* data, std::shared_ptr<lox::Object> arg) = 0;
 
+	/// only the actors touching the solid are asked if they are riding it
 	ActorList get_all_riding_actors();
 
+	/// call when the position or size was changed without the move functions
+	void update_broadphase();
+
 	bool is_overlapping(const std::shared_ptr<Actor>& actor);
 
 	void Move(float x, float y);
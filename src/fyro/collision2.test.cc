@@ -0,0 +1,412 @@
+#include "catch.hpp"
+
+#include "fyro/collision2.h"
+
+#include <random>
+
+namespace
+{
+	Recti tile(int x, int y)
+	{
+		return Recti::from_xywh(x * 16, y * 16, 16, 16);
+	}
+
+	bool is_covered(const std::vector<Recti>& rects, int x, int y)
+	{
+		for (const auto& r: rects)
+		{
+			if (x >= r.left && x < r.right && y >= r.bottom && y < r.top)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	struct TestActor : fyro::Actor
+	{
+		void update(float) override
+		{
+		}
+
+		void render(RenderData*, std::shared_ptr<lox::Object>) override
+		{
+		}
+
+		bool is_riding_solid(fyro::Solid*) override
+		{
+			return false;
+		}
+
+		void get_squished() override
+		{
+		}
+	};
+
+	struct TestSolid : fyro::Solid
+	{
+		void update(float) override
+		{
+		}
+
+		void render(RenderData*, std::shared_ptr<lox::Object>) override
+		{
+		}
+	};
+
+	// how the actors moved before the sweep, one collide_at per pixel
+	bool step(fyro::Actor* actor, const glm::ivec2& direction, int steps)
+	{
+		for (int index = 0; index < steps; index += 1)
+		{
+			if (actor->collide_at(actor->position + direction))
+			{
+				return true;
+			}
+			actor->position += direction;
+		}
+		return false;
+	}
+
+	int get_area(const std::vector<Recti>& rects)
+	{
+		int area = 0;
+		for (const auto& r: rects)
+		{
+			area += r.get_width() * r.get_height();
+		}
+		return area;
+	}
+}  //  namespace
+
+TEST_CASE("collision2: merge a row of tiles", "[collision2]")
+{
+	const auto merged = fyro::merge_rects({tile(0, 0), tile(1, 0), tile(2, 0), tile(3, 0)});
+	REQUIRE(merged.size() == 1);
+	CHECK(merged[0].left == 0);
+	CHECK(merged[0].bottom == 0);
+	CHECK(merged[0].right == 64);
+	CHECK(merged[0].top == 16);
+}
+
+TEST_CASE("collision2: merge a block of tiles", "[collision2]")
+{
+	const auto merged = fyro::merge_rects({tile(1, 1), tile(0, 0), tile(0, 1), tile(1, 0)});
+	REQUIRE(merged.size() == 1);
+	CHECK(merged[0].left == 0);
+	CHECK(merged[0].bottom == 0);
+	CHECK(merged[0].right == 32);
+	CHECK(merged[0].top == 32);
+}
+
+TEST_CASE("collision2: merge an l shape", "[collision2]")
+{
+	// ##
+	// #
+	const auto merged = fyro::merge_rects({tile(0, 0), tile(0, 1), tile(1, 1)});
+	CHECK(merged.size() == 2);
+	CHECK(get_area(merged) == 3 * 16 * 16);
+}
+
+TEST_CASE("collision2: merge overlapping and empty rects", "[collision2]")
+{
+	const auto merged = fyro::merge_rects(
+		{Recti::from_xywh(0, 0, 10, 10), Recti::from_xywh(5, 0, 10, 10), Recti::from_xywh(3, 3, 0, 0)}
+	);
+	REQUIRE(merged.size() == 1);
+	CHECK(merged[0].left == 0);
+	CHECK(merged[0].right == 15);
+	CHECK(get_area(merged) == 150);
+}
+
+TEST_CASE("collision2: merge keeps the covered area", "[collision2]")
+{
+	// a fixed pattern with holes, sub-tile rects and overlaps
+	std::vector<Recti> rects;
+	for (int y = 0; y < 8; y += 1)
+	{
+		for (int x = 0; x < 8; x += 1)
+		{
+			if ((x * 7 + y * 3) % 5 != 0)
+			{
+				rects.emplace_back(tile(x, y));
+			}
+		}
+	}
+	rects.emplace_back(Recti::from_xywh(4, 4, 30, 6));
+	rects.emplace_back(Recti::from_xywh(100, 8, 8, 60));
+
+	const auto merged = fyro::merge_rects(rects);
+	CHECK(merged.size() < rects.size());
+
+	for (int y = -1; y < 8 * 16 + 1; y += 1)
+	{
+		for (int x = -1; x < 8 * 16 + 1; x += 1)
+		{
+			CHECK(is_covered(rects, x, y) == is_covered(merged, x, y));
+		}
+	}
+
+	// the merged rects never overlap
+	for (std::size_t lhs = 0; lhs < merged.size(); lhs += 1)
+	{
+		for (std::size_t rhs = lhs + 1; rhs < merged.size(); rhs += 1)
+		{
+			CHECK_FALSE(rect_intersect(merged[lhs], merged[rhs]));
+		}
+	}
+}
+
+TEST_CASE("collision2: tile grid collisions", "[collision2]")
+{
+	// a floor along the bottom and a half tile sized block at (2, 1)
+	const auto grid = fyro::TileGridCollider{
+		{16, 16},
+		{4, 3},
+		{tile(0, 0), tile(1, 0), tile(2, 0), tile(3, 0), Recti::from_xywh(32, 16, 8, 8)}
+	};
+
+	SECTION("overlapping the floor")
+	{
+		CHECK(grid.collides(Recti::from_xywh(10, 10, 4, 10)));
+		CHECK(grid.collides(Recti::from_xywh(-5, 0, 10, 10)));
+	}
+
+	SECTION("standing on the floor isn't a collision")
+	{
+		CHECK_FALSE(grid.collides(Recti::from_xywh(10, 16, 4, 10)));
+	}
+
+	SECTION("only the sub rect of a tile is solid")
+	{
+		CHECK(grid.collides(Recti::from_xywh(38, 22, 4, 4)));
+		CHECK_FALSE(grid.collides(Recti::from_xywh(40, 17, 4, 4)));
+		CHECK_FALSE(grid.collides(Recti::from_xywh(33, 24, 4, 4)));
+	}
+
+	SECTION("a rect covering many cells")
+	{
+		CHECK(grid.collides(Recti::from_xywh(20, 20, 40, 20)));
+		CHECK_FALSE(grid.collides(Recti::from_xywh(0, 30, 64, 18)));
+	}
+
+	SECTION("outside of the grid")
+	{
+		CHECK_FALSE(grid.collides(Recti::from_xywh(100, 100, 10, 10)));
+		CHECK_FALSE(grid.collides(Recti::from_xywh(-50, -50, 10, 10)));
+	}
+}
+
+TEST_CASE("collision2: tile grid rects can span cells", "[collision2]")
+{
+	const auto grid = fyro::TileGridCollider{{16, 16}, {4, 4}, {Recti::from_xywh(8, 8, 32, 16)}};
+	CHECK(grid.collides(Recti::from_xywh(38, 22, 4, 4)));
+	CHECK(grid.collides(Recti::from_xywh(0, 0, 10, 10)));
+	CHECK_FALSE(grid.collides(Recti::from_xywh(40, 8, 8, 8)));
+	CHECK_FALSE(grid.collides(Recti::from_xywh(0, 24, 64, 8)));
+}
+
+TEST_CASE("collision2: spatial hash", "[collision2]")
+{
+	constexpr fyro::ColliderHandle small = 0;
+	constexpr fyro::ColliderHandle large = 1;
+	constexpr fyro::ColliderHandle far = 2;
+
+	auto hash = fyro::SpatialHash{64};
+	hash.place(large, Recti{0, 0, 200, 200});
+	hash.place(small, Recti::from_xywh(10, 10, 8, 8));
+	hash.place(far, Recti::from_xywh(1000, -1000, 8, 8));
+
+	std::vector<fyro::ColliderHandle> found;
+
+	SECTION("colliders are found once, sorted by handle")
+	{
+		hash.query(Recti{0, 0, 300, 300}, &found);
+		CHECK(found == std::vector<fyro::ColliderHandle>{small, large});
+	}
+
+	SECTION("negative cells")
+	{
+		hash.query(Recti::from_xywh(1000, -1000, 1, 1), &found);
+		CHECK(found == std::vector<fyro::ColliderHandle>{far});
+	}
+
+	SECTION("moved colliders are found where they are placed")
+	{
+		hash.place(small, Recti::from_xywh(500, 500, 8, 8));
+		hash.query(Recti::from_xywh(10, 10, 1, 1), &found);
+		CHECK(found == std::vector<fyro::ColliderHandle>{large});
+		hash.query(Recti::from_xywh(500, 500, 1, 1), &found);
+		CHECK(found == std::vector<fyro::ColliderHandle>{small});
+	}
+
+	SECTION("removed colliders are not found")
+	{
+		hash.remove(large);
+		hash.query(Recti{0, 0, 300, 300}, &found);
+		CHECK(found == std::vector<fyro::ColliderHandle>{small});
+	}
+}
+
+TEST_CASE("collision2: batched overlap tests match the single rect tests", "[collision2]")
+{
+	auto rng = std::mt19937{42};
+	const auto random = [&](int min, int max)
+	{ return std::uniform_int_distribution<int>{min, max}(rng); };
+
+	// not a multiple of the lanes so the rest is tested too
+	constexpr std::size_t count = fyro::collider_lanes * 4 + 3;
+	fyro::ColliderBounds bounds;
+	bounds.resize(count);
+	for (std::size_t index = 0; index < count; index += 1)
+	{
+		bounds.set(
+			index, Recti::from_xywh(random(-50, 50), random(-50, 50), random(0, 30), random(0, 30))
+		);
+	}
+
+	std::vector<u8> overlaps(count);
+	std::vector<i32> steps(count);
+	for (int test = 0; test < 100; test += 1)
+	{
+		const auto rect
+			= Recti::from_xywh(random(-60, 60), random(-60, 60), random(0, 30), random(0, 30));
+		const auto sign = random(0, 1) == 0 ? -1 : 1;
+		const auto direction = random(0, 1) == 0 ? glm::ivec2{sign, 0} : glm::ivec2{0, sign};
+		const auto distance = random(1, 80);
+
+		// the second range doesn't start at a batch
+		for (const std::size_t begin: {std::size_t{0}, std::size_t{3}})
+		{
+			fyro::get_overlaps(rect, bounds, begin, count, overlaps.data());
+			fyro::get_first_overlaps(rect, bounds, begin, count, direction, distance, steps.data());
+
+			bool any = false;
+			std::optional<int> first;
+			for (std::size_t index = begin; index < count; index += 1)
+			{
+				const auto other = bounds.get(index);
+				const auto overlap = rect_intersect(rect, other);
+				const auto step = fyro::get_first_overlap(rect, other, direction, distance);
+				CHECK((overlaps[index - begin] != 0) == overlap);
+				CHECK(steps[index - begin] == step.value_or(0));
+
+				any = any || overlap;
+				if (step && (! first || *step < *first))
+				{
+					first = step;
+				}
+			}
+
+			CHECK(fyro::has_overlap(rect, bounds, begin, count) == any);
+			CHECK(
+				fyro::get_first_overlap(rect, bounds, begin, count, direction, distance) == first
+			);
+		}
+	}
+}
+
+TEST_CASE("collision2: sweeping moves like stepping a pixel at a time", "[collision2]")
+{
+	auto rng = std::mt19937{42};
+	const auto random = [&](int min, int max)
+	{ return std::uniform_int_distribution<int>{min, max}(rng); };
+
+	for (int level_index = 0; level_index < 50; level_index += 1)
+	{
+		fyro::Level level;
+
+		// tiles that are partly solid, a few loose solids and an actor that is in the way
+		std::vector<Recti> tile_rects;
+		for (int index = 0; index < 20; index += 1)
+		{
+			tile_rects.emplace_back(Recti::from_xywh(
+				random(0, 9) * 16, random(0, 9) * 16, random(1, 16), random(1, 16)
+			));
+		}
+		level.tiles = fyro::TileGridCollider{{16, 16}, {10, 10}, tile_rects};
+
+		for (int index = 0; index < 5; index += 1)
+		{
+			auto solid = std::make_shared<TestSolid>();
+			solid->level = &level;
+			solid->position = {random(-20, 180), random(-20, 180)};
+			solid->size = Recti{random(0, 40), random(0, 40)};
+			solid->is_collidable = random(0, 4) != 0;
+			level.add_solid(solid);
+		}
+
+		auto other = std::make_shared<TestActor>();
+		other->level = &level;
+		other->position = {random(0, 160), random(0, 160)};
+		level.add_actor(other);
+
+		auto actor = std::make_shared<TestActor>();
+		actor->level = &level;
+		actor->position = {random(-20, 180), random(-20, 180)};
+		actor->size = Recti{random(0, 20), random(0, 20)};
+		level.add_actor(actor);
+
+		for (int move = 0; move < 20; move += 1)
+		{
+			const auto distance = random(-40, 40);
+			const auto is_x = random(0, 1) == 0;
+			const auto start = actor->position;
+
+			const auto direction = (is_x ? glm::ivec2{1, 0} : glm::ivec2{0, 1})
+								 * (distance < 0 ? -1 : 1);
+			const auto stepped_collision = step(actor.get(), direction, std::abs(distance));
+			const auto stepped = actor->position;
+
+			actor->position = start;
+			actor->update_broadphase();
+			bool reacted = false;
+			const auto on_collision = [&]() { reacted = true; };
+			const auto swept_collision = is_x ? actor->please_move_x(distance, on_collision)
+											  : actor->please_move_y(distance, on_collision);
+
+			CHECK(actor->position == stepped);
+			CHECK(swept_collision == stepped_collision);
+			CHECK(reacted == swept_collision);
+		}
+	}
+}
+
+TEST_CASE("collision2: contacts are sent once per frame", "[collision2]")
+{
+	fyro::Level level;
+	using Sent = std::vector<std::pair<fyro::Actor*, fyro::Actor*>>;
+	Sent sent;
+	level.on_contact = [&](fyro::Actor* lhs, fyro::Actor* rhs) { sent.emplace_back(lhs, rhs); };
+
+	const auto add = [&](int x)
+	{
+		auto actor = std::make_shared<TestActor>();
+		actor->level = &level;
+		actor->position = {x, 0};
+		level.add_actor(actor);
+		return actor;
+	};
+	auto first = add(0);
+	auto second = add(5);
+	auto third = add(100);
+
+	SECTION("overlapping actors are sent every frame")
+	{
+		level.update(0.0f);
+		CHECK(sent == Sent{{first.get(), second.get()}});
+
+		sent.clear();
+		level.update(0.0f);
+		CHECK(sent == Sent{{first.get(), second.get()}});
+	}
+
+	SECTION("actors passed on the way are sent once")
+	{
+		third->please_move_x(-200, fyro::no_collision_reaction);
+		third->please_move_x(200, fyro::no_collision_reaction);
+		level.dispatch_contacts();
+		CHECK(sent == Sent{{first.get(), third.get()}, {second.get(), third.get()}});
+		CHECK(level.contacts.empty());
+	}
+}
@@ -0,0 +1,72 @@
+#include "fyro/cooked.h"
+
+#include "fyro/exception.h"
+
+namespace
+{
+	constexpr u32 cooked_magic = 0x6f727966;  // "fyro"
+}  //  namespace
+
+std::string get_cooked_path(const std::string& source_path)
+{
+	return source_path + ".cooked";
+}
+
+u64 get_source_hash(const std::string& source)
+{
+	// 64 bit fnv-1a
+	u64 hash = 0xcbf29ce484222325;
+	for (const auto c: source)
+	{
+		hash ^= static_cast<u8>(c);
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+CookedWriter::CookedWriter(u32 version, u64 source_hash)
+{
+	write(cooked_magic);
+	write(version);
+	write(source_hash);
+}
+
+void CookedWriter::write_string(const std::string& str)
+{
+	write(static_cast<u32>(str.size()));
+	data.insert(data.end(), str.begin(), str.end());
+}
+
+CookedReader::CookedReader(const std::vector<char>& bytes, u32 version)
+	: data(bytes.data())
+	, size(bytes.size())
+{
+	if (size < sizeof(u32) * 2 + sizeof(u64))
+	{
+		return;
+	}
+
+	const auto magic = read<u32>();
+	const auto file_version = read<u32>();
+	source_hash = read<u64>();
+	is_valid = magic == cooked_magic && file_version == version;
+}
+
+std::string CookedReader::read_string()
+{
+	const auto length = read<u32>();
+	const auto* bytes = get_bytes(length);
+	return std::string{bytes, bytes + length};
+}
+
+const char* CookedReader::get_bytes(std::size_t count)
+{
+	if (count > size - offset)
+	{
+		throw Exception{{"cooked file is too short"}};
+	}
+
+	const auto* r = data + offset;
+	offset += count;
+	return r;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#include "fyro/types.h"
+
+/*
+Cooked files are prebuilt data that can be loaded without parsing.
+The values are written as they are laid out in memory, so a cooked file only loads on the platform
+it was cooked on, the header makes sure the loader rejects files from other versions.
+The header also has a hash of the source file so the loader can tell when the source was edited
+after it was cooked.
+*/
+
+/// the file the cooked version of a source file is stored in, the cooked file sits next to the source
+std::string get_cooked_path(const std::string& source_path);
+
+/// the hash of the source file that is stored in the header of the cooked file
+u64 get_source_hash(const std::string& source);
+
+/** Builds a cooked file in memory */
+struct CookedWriter
+{
+	std::vector<char> data;
+
+	/// starts the file with the header
+	CookedWriter(u32 version, u64 source_hash);
+
+	template<typename T>
+	void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		const auto* bytes = reinterpret_cast<const char*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+
+	/// the size followed by the items
+	template<typename T>
+	void write_array(const std::vector<T>& items)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		write(static_cast<u32>(items.size()));
+		const auto* bytes = reinterpret_cast<const char*>(items.data());
+		data.insert(data.end(), bytes, bytes + items.size() * sizeof(T));
+	}
+
+	void write_string(const std::string& str);
+};
+
+/** Reads a cooked file from memory, throws if the file is too short */
+struct CookedReader
+{
+	const char* data;
+	std::size_t size;
+	std::size_t offset = 0;
+	bool is_valid = false;	// false if the file was cooked by another version
+	u64 source_hash = 0;  // the hash of the source it was cooked from, compare to get_source_hash
+
+	/// reads and validates the header
+	CookedReader(const std::vector<char>& bytes, u32 version);
+
+	template<typename T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		// not every byte is a valid bool, read a u8 and compare it to 0 instead
+		static_assert(std::is_same_v<T, bool> == false);
+		T r;
+		std::memcpy(&r, get_bytes(sizeof(T)), sizeof(T));
+		return r;
+	}
+
+	template<typename T>
+	std::vector<T> read_array()
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		// validate the size before allocating, a corrupt count could be huge
+		const auto count = read<u32>();
+		const auto* bytes = get_bytes(count * sizeof(T));
+		std::vector<T> r(count);
+		if (count > 0)
+		{
+			std::memcpy(r.data(), bytes, count * sizeof(T));
+		}
+		return r;
+	}
+
+	std::string read_string();
+
+	/// moves past the bytes and returns where they start
+	const char* get_bytes(std::size_t count);
+};
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include "fyro/cooked.h"
+
+#include <limits>
+
+TEST_CASE("cooked: read what was written", "[cooked]")
+{
+	auto writer = CookedWriter{3, 0};
+	writer.write(42);
+	writer.write_string("level.png");
+	writer.write_array(std::vector<float>{1.0f, 2.5f});
+	writer.write_array(std::vector<u32>{});
+
+	auto reader = CookedReader{writer.data, 3};
+	REQUIRE(reader.is_valid);
+	CHECK(reader.read<int>() == 42);
+	CHECK(reader.read_string() == "level.png");
+	CHECK(reader.read_array<float>() == std::vector<float>{1.0f, 2.5f});
+	CHECK(reader.read_array<u32>().empty());
+	CHECK(reader.offset == writer.data.size());
+}
+
+TEST_CASE("cooked: other versions are rejected", "[cooked]")
+{
+	const auto writer = CookedWriter{1, 0};
+	CHECK_FALSE((CookedReader{writer.data, 2}.is_valid));
+	CHECK_FALSE((CookedReader{std::vector<char>{'f', 'y'}, 1}.is_valid));
+}
+
+TEST_CASE("cooked: the header has the hash of the source", "[cooked]")
+{
+	const auto hash = get_source_hash("<map/>");
+	CHECK(hash != get_source_hash("<map />"));
+	CHECK(hash != get_source_hash(""));
+
+	const auto writer = CookedWriter{1, hash};
+	const auto reader = CookedReader{writer.data, 1};
+	REQUIRE(reader.is_valid);
+	CHECK(reader.source_hash == hash);
+	CHECK(reader.offset == writer.data.size());
+}
+
+TEST_CASE("cooked: reading past the end throws", "[cooked]")
+{
+	auto writer = CookedWriter{1, 0};
+	writer.write(static_cast<u32>(100));
+
+	auto reader = CookedReader{writer.data, 1};
+	REQUIRE(reader.is_valid);
+	CHECK_THROWS(reader.read_array<u32>());
+}
+
+TEST_CASE("cooked: a corrupt array size throws before allocating", "[cooked]")
+{
+	auto writer = CookedWriter{1, 0};
+	writer.write(std::numeric_limits<u32>::max());
+
+	auto reader = CookedReader{writer.data, 1};
+	REQUIRE(reader.is_valid);
+	CHECK_THROWS(reader.read_array<u64>());
+}
@@ -146,7 +146,7 @@ ExampleGame::ExampleGame()
 
 	bind::bind_phys_actor(&lox);
 	bind::bind_phys_solid(&lox);
-	bind::bind_phys_level(&lox);
+	bind::bind_phys_level(&lox, &texture_cache);
 
 	bind::bind_fun_set_state(&lox, &next_state);
 
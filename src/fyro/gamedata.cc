@@ -32,6 +32,11 @@ GameData load_game_data_or_default(const std::string& path)
 			r.title = data["title"].get<std::string>();
 			r.width = data["width"].get<int>();
 			r.height = data["height"].get<int>();
+			r.batch_quads = data.value("batch_quads", r.batch_quads);
+			r.max_batch_quads = data.value("max_batch_quads", r.max_batch_quads);
+			r.packed_vertices = data.value("packed_vertices", r.packed_vertices);
+			r.multi_texture = data.value("multi_texture", r.multi_texture);
+			r.instanced_sprites = data.value("instanced_sprites", r.instanced_sprites);
 			return r;
 		}
 		else
@@ -5,6 +5,13 @@ struct GameData
 	std::string title = "fyro";
 	int width = 800;
 	int height = 600;
+
+	// sprite batch capacity, tune for the number of quads the game draws
+	int batch_quads = 100;
+	int max_batch_quads = 10000;
+	bool packed_vertices = false;
+	bool multi_texture = false;
+	bool instanced_sprites = false;
 };
 
 GameData load_game_data_or_default(const std::string& path);
@@ -4,12 +4,14 @@
 #include "fyro/vfs.h"
 #include "fyro/gamedata.h"
 #include "fyro/game.h"
+#include "fyro/bind.physics.h"
 
 int run(int argc, char** argv)
 {
 	auto physfs = Physfs(argv[0]);
 	bool call_imgui = false;
 	std::optional<std::string> folder_arg;
+	std::vector<std::string> levels_to_cook;
 
 	for (int index = 1; index < argc; index += 1)
 	{
@@ -18,6 +20,16 @@ int run(int argc, char** argv)
 		{
 			call_imgui = true;
 		}
+		else if (cmd == "--cook")
+		{
+			if (index + 1 >= argc)
+			{
+				LOG_WARNING("--cook requires the tmx file to cook");
+				return -1;
+			}
+			index += 1;
+			levels_to_cook.emplace_back(argv[index]);
+		}
 		else
 		{
 			if (folder_arg)
@@ -41,12 +53,36 @@ int run(int argc, char** argv)
 		physfs.setup_with_default_root();
 	}
 
+	// cook the levels next to the source files and exit without starting the game
+	if (levels_to_cook.empty() == false)
+	{
+		if (! folder_arg)
+		{
+			LOG_WARNING("--cook requires the game folder to write the cooked levels to");
+			return -1;
+		}
+		physfs.setup_write_root(cannonical_folder(*folder_arg));
+		for (const auto& level: levels_to_cook)
+		{
+			cook_level(level);
+		}
+		return 0;
+	}
+
 	const auto data = load_game_data_or_default("main.json");
 
+	auto batch = render::BatchSettings{};
+	batch.quads = data.batch_quads;
+	batch.max_quads = data.max_batch_quads;
+	batch.format = data.packed_vertices ? render::VertexFormat::packed : render::VertexFormat::full;
+	batch.multi_texture = data.multi_texture;
+	batch.instanced = data.instanced_sprites;
+
 	return run_game(
 		data.title,
 		glm::ivec2{data.width, data.height},
 		call_imgui,
+		batch,
 		[]()
 		{
 			auto game = std::make_shared<ExampleGame>();
@@ -7,6 +7,7 @@
 #include <set>
 #include "fyro/assert.h"
 #include <iostream>
+#include <fstream>
 
 
 
@@ -18,7 +19,9 @@
 #include "fyro/dependencies/dependency_sdl.h"
 
 #include "fyro/log.h"
+#include "fyro/render/backend.h"
 #include "fyro/render/opengl_utils.h"
+#include "fyro/render/profiler.h"
 #include "fyro/types.h"
 #include "fyro/render/texture.h"
 #include "fyro/render/viewportdef.h"
@@ -105,6 +108,22 @@ void setup_open_gl(
 	const char* glsl_version = "#version 130";
 	ImGui_ImplOpenGL3_Init(glsl_version);
 }
+
+constexpr const char* const timers_file = "fyro-timers.txt";
+
+void save_timers(const render::Profiler& profiler)
+{
+	auto file = std::ofstream{timers_file};
+	file << render::to_string(profiler);
+	if (file)
+	{
+		LOG_INFO("Saved timers to {}", timers_file);
+	}
+	else
+	{
+		LOG_WARNING("Failed to save timers to {}", timers_file);
+	}
+}
 }  //  namespace
 
 struct Window
@@ -174,6 +193,10 @@ struct Window
 
 	~Window()
 	{
+		// the game may hold gpu resources of the render so destroy both while the context is alive
+		game.reset();
+		render_data.reset();
+
 		if (sdl_window)
 		{
 			if (imgui)
@@ -194,12 +217,19 @@ struct Window
 			return;
 		}
 
+		render_data->start_new_frame();
+		auto& profiler = render_data->profiler;
+		const auto frame_timer = render::ScopedTimer{&profiler, "frame", true};
+
 		glViewport(0, 0, size.x, size.y);
 
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-		game->on_render({states, render_data.get(), size});
+		{
+			const auto game_timer = render::ScopedTimer{&profiler, "Game::on_render"};
+			game->on_render({states, render_data.get(), size});
+		}
 
 		if (imgui)
 		{
@@ -209,6 +239,46 @@ struct Window
 
 			game->on_imgui();
 
+			if (ImGui::Begin("Render"))
+			{
+				const auto& stats = render_data->batch.last_frame;
+				ImGui::Text("Flushes: %d", stats.flushes);
+				ImGui::Text("Stalls: %d", stats.stalls);
+				ImGui::Text("Draw calls: %d", stats.draw_calls);
+				ImGui::Text("Quads: %d", stats.quads);
+				ImGui::Text(
+					"Capacity: %d/%d", render_data->batch.capacity, render_data->batch.max_quads
+				);
+				ImGui::Text("Texture slots: %d", render_data->texture_slots);
+			}
+			ImGui::End();
+
+			if (ImGui::Begin("Timers"))
+			{
+				ImGui::TextUnformatted("average per frame, cpu ms / gpu ms");
+				for (const auto& timer: profiler.timers)
+				{
+					if (timer.gpu_ms.samples.empty())
+					{
+						ImGui::Text("%s: %.3f", timer.name.c_str(), timer.cpu_ms.get());
+					}
+					else
+					{
+						ImGui::Text(
+							"%s: %.3f / %.3f",
+							timer.name.c_str(),
+							timer.cpu_ms.get(),
+							timer.gpu_ms.get()
+						);
+					}
+				}
+				if (ImGui::Button("Save"))
+				{
+					save_timers(profiler);
+				}
+			}
+			ImGui::End();
+
 			ImGui::Render();
 			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 		}
@@ -322,7 +392,8 @@ int setup_and_run(
 	std::function<std::shared_ptr<Game>()> make_game,
 	const std::string& title,
 	const glm::ivec2& size,
-	bool call_imgui
+	bool call_imgui,
+	const render::BatchSettings& batch_settings
 )
 {
 	render::OpenglStates states;
@@ -331,7 +402,11 @@ int setup_and_run(
 	{
 		return -1;
 	}
-	window.render_data = std::make_unique<render::Render2>();
+	window.render_data = std::make_unique<render::Render2>(
+		render::create_opengl_backend(&states, batch_settings), batch_settings
+	);
+	// the timers are only shown in the imgui window
+	window.render_data->profiler.enabled = call_imgui;
 	window.game = make_game();
 
 	auto last = SDL_GetPerformanceCounter();
@@ -359,6 +434,7 @@ int run_game(
 	const std::string& title,
 	const glm::ivec2& size,
 	bool call_imgui,
+	const render::BatchSettings& batch_settings,
 	std::function<std::shared_ptr<Game>()> make_game
 )
 {
@@ -383,7 +459,7 @@ int run_game(
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
-	const auto ret = setup_and_run(make_game, title, size, call_imgui);
+	const auto ret = setup_and_run(make_game, title, size, call_imgui, batch_settings);
 
 	SDL_Quit();
 	return ret;
@@ -54,5 +54,6 @@ int run_game(
 	const std::string& title,
 	const glm::ivec2& size,
 	bool call_imgui,
+	const render::BatchSettings& batch_settings,
 	std::function<std::shared_ptr<Game>()> make_game
 );
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <memory>
+
+#include "fyro/rect.h"
+#include "fyro/types.h"
+
+namespace render
+{
+
+struct Texture;
+struct BatchStats;
+struct BatchSettings;
+struct OpenglStates;
+
+/** What the staging data of a SpriteBatch contains */
+enum class BatchContent
+{
+	/// four vertices per quad
+	quads,
+
+	/// one instance per sprite
+	sprites
+};
+
+/** A filled SpriteBatch that is ready to be drawn */
+struct BatchDraw
+{
+	BatchContent content;
+	const u8* data;
+	std::size_t size;  // in bytes
+	int count;	// number of quads or sprites
+	int capacity;  // current capacity of the batch, the backend can size its buffers after it
+	const std::vector<Texture*>* textures;	// one per texture slot
+};
+
+/** The quads of a StaticQuads */
+struct StaticUpload
+{
+	const u8* data;	 // laid out like the batch quads with texture slot 0
+	std::size_t size;  // in bytes
+	int quads;
+	const std::vector<u32>* animations;	 // one per vertex, 0 or the animation + 1
+};
+
+/** A single frame of a TileAnimation */
+struct AnimationFrame
+{
+	glm::vec2 uv_offset;  // from the uvs of the animated quad
+	float duration;	 // in seconds
+};
+
+/** A uv animation that the gpu plays on the quads that refer to it */
+struct TileAnimation
+{
+	std::vector<AnimationFrame> frames;
+};
+
+/** How a StaticQuads is drawn */
+struct StaticDraw
+{
+	const Texture* texture;
+	u32 animations = 0;	 // from create_animations or 0 if not animated
+	float time = 0.0f;	// in seconds, selects the animation frame
+};
+
+/** The gpu side of the 2d renderer.
+ * The opengl backend draws, the recording backend captures the calls in memory so the cpu side of
+ * the rendering can be profiled and compared against golden command streams without a gpu.
+ */
+struct Backend
+{
+	Backend() = default;
+	virtual ~Backend() = default;
+
+	Backend(const Backend&) = delete;
+	void operator=(const Backend&) = delete;
+	Backend(Backend&&) = delete;
+	void operator=(Backend&&) = delete;
+
+	/// the number of textures a single batch can use
+	virtual int get_texture_slots() const = 0;
+
+	/// the texture used for quads without a texture
+	virtual Texture create_white_texture() = 0;
+
+	virtual void set_viewport(const Recti& screen) = 0;
+	virtual void set_2d() = 0;
+	virtual void clear(const glm::vec3& color) = 0;
+	virtual void set_view_projection(const glm::mat4& view_projection) = 0;
+	virtual void set_transform(const glm::mat4& transform) = 0;
+	virtual void draw(const BatchDraw& batch, BatchStats* stats) = 0;
+
+	/// create a gpu buffer for quads that are drawn many times, see StaticQuads
+	virtual u32 create_static_quads() = 0;
+	virtual void destroy_static_quads(u32 id) = 0;
+
+	/// replace all the quads
+	virtual void upload_static_quads(u32 id, const StaticUpload& upload) = 0;
+
+	virtual void draw_static_quads(u32 id, const StaticDraw& draw, BatchStats* stats) = 0;
+
+	/// upload a table of animations that static quads can refer to
+	virtual u32 create_animations(const std::vector<TileAnimation>& animations) = 0;
+	virtual void destroy_animations(u32 id) = 0;
+
+	/// record the time when the gpu reaches this point, null if gpu timers aren't supported
+	virtual std::optional<u32> add_gpu_timestamp() = 0;
+
+	/// the recorded time in nanoseconds or null if the gpu isn't there yet, the query is freed once
+	/// it returns a time
+	virtual std::optional<u64> get_gpu_timestamp(u32 query) = 0;
+};
+
+std::unique_ptr<Backend> create_opengl_backend(OpenglStates* states, const BatchSettings& settings);
+
+}  //  namespace render
@@ -0,0 +1,1096 @@
+#include "fyro/render/backend.h"
+
+#include <cstring>
+#include <map>
+
+#include "fyro/dependencies/dependency_opengl.h"
+
+#include "fyro/cint.h"
+#include "fyro/render/opengl_utils.h"
+#include "fyro/render/quad_writer.h"
+#include "fyro/render/render2.h"
+#include "fyro/render/shader.h"
+#include "fyro/render/static_quads.h"
+#include "fyro/render/texture.h"
+#include "fyro/render/vertex_layout.h"
+
+namespace render
+{
+
+void set_gl_viewport(const Recti& r);
+
+namespace
+{
+	// the ring buffer holds at least this many quads...
+	constexpr int ring_quads = 6400;
+
+	// ...and at least this many regions so a few frames can be in flight
+	constexpr int min_ring_regions = 3;
+
+	// largest number of quads that can be addressed with u16 indices
+	constexpr int max_small_index_quads = 65536 / 4;
+
+	constexpr GLuint64 fence_timeout_ns = 1000 * 1000 * 1000;
+
+	/** How a single vertex attribute is stored in the vertex buffer */
+	struct AttributeFormat
+	{
+		int count;
+		GLenum type;
+		GLboolean normalized;
+		std::size_t size;
+		bool integer = false;
+	};
+
+	AttributeFormat get_attribute_format(VertexType type, VertexFormat format)
+	{
+		const auto packed = format == VertexFormat::packed;
+		switch (type)
+		{
+		case VertexType::position2:
+			// the full format keeps the z of Vertex3
+			return packed ? AttributeFormat{2, GL_FLOAT, GL_FALSE, 2 * sizeof(float)}
+						  : AttributeFormat{3, GL_FLOAT, GL_FALSE, 3 * sizeof(float)};
+		case VertexType::color4:
+			return packed ? AttributeFormat{4, GL_UNSIGNED_BYTE, GL_TRUE, 4 * sizeof(u8)}
+						  : AttributeFormat{4, GL_FLOAT, GL_FALSE, 4 * sizeof(float)};
+		case VertexType::texture2:
+			return packed ? AttributeFormat{2, GL_UNSIGNED_SHORT, GL_TRUE, 2 * sizeof(u16)}
+						  : AttributeFormat{2, GL_FLOAT, GL_FALSE, 2 * sizeof(float)};
+		case VertexType::texture_slot1:
+			return AttributeFormat{1, GL_UNSIGNED_INT, GL_FALSE, sizeof(TextureSlot), true};
+		case VertexType::rect4: return AttributeFormat{4, GL_FLOAT, GL_FALSE, 4 * sizeof(float)};
+		case VertexType::animation1:
+			return AttributeFormat{1, GL_UNSIGNED_INT, GL_FALSE, sizeof(u32), true};
+		case VertexType::texture_rect4:
+			return packed ? AttributeFormat{4, GL_UNSIGNED_SHORT, GL_TRUE, 4 * sizeof(u16)}
+						  : AttributeFormat{4, GL_FLOAT, GL_FALSE, 4 * sizeof(float)};
+		default:
+			DIE("vertex type not supported by the sprite batch");
+			return {0, GL_FLOAT, GL_FALSE, 0};
+		}
+	}
+
+	// enable the attributes in layout order, a divisor of 1 makes them per instance
+	void enable_attributes(
+		const CompiledShaderVertexAttributes& layout,
+		VertexFormat format,
+		std::size_t stride,
+		GLuint divisor
+	)
+	{
+		std::size_t offset = 0;
+		for (const auto& element: layout.elements)
+		{
+			const auto attribute = get_attribute_format(element.type, format);
+			const auto index = Cint_to_gluint(element.index);
+			glEnableVertexAttribArray(index);
+			if (attribute.integer)
+			{
+				glVertexAttribIPointer(
+					index,
+					attribute.count,
+					attribute.type,
+					Csizet_to_glsizei(stride),
+					reinterpret_cast<void*>(offset)
+				);
+			}
+			else
+			{
+				glVertexAttribPointer(
+					index,
+					attribute.count,
+					attribute.type,
+					attribute.normalized,
+					Csizet_to_glsizei(stride),
+					reinterpret_cast<void*>(offset)
+				);
+			}
+			glVertexAttribDivisor(index, divisor);
+			offset += attribute.size;
+		}
+
+		ASSERT(offset == stride);
+	}
+
+	// setup the attributes from the quad layout, they must come in the order add_vertex writes them
+	void setup_vertex_attributes(
+		const CompiledShaderVertexAttributes& layout, VertexFormat format, bool multi_texture
+	)
+	{
+		ASSERT(layout.elements.size() == (multi_texture ? 4 : 3));
+		ASSERT(layout.elements[0].type == VertexType::position2);
+		ASSERT(layout.elements[1].type == VertexType::color4);
+		ASSERT(layout.elements[2].type == VertexType::texture2);
+		ASSERT(multi_texture == false || layout.elements[3].type == VertexType::texture_slot1);
+
+		enable_attributes(layout, format, get_vertex_size(format, multi_texture), 0);
+	}
+
+	// setup the per instance attributes, they must come in the order add_sprite writes them
+	void setup_sprite_attributes(
+		const CompiledShaderVertexAttributes& layout, VertexFormat format, bool multi_texture
+	)
+	{
+		ASSERT(layout.elements.size() == (multi_texture ? 4 : 3));
+		ASSERT(layout.elements[0].type == VertexType::rect4);
+		ASSERT(layout.elements[1].type == VertexType::color4);
+		ASSERT(layout.elements[2].type == VertexType::texture_rect4);
+		ASSERT(multi_texture == false || layout.elements[3].type == VertexType::texture_slot1);
+
+		enable_attributes(layout, format, get_sprite_size(format, multi_texture), 1);
+	}
+
+	template<typename T>
+	std::vector<T> create_quad_indices(int quads)
+	{
+		std::vector<T> indices;
+		indices.reserve(6 * Cint_to_sizet(quads));
+
+		for (auto quad_index = 0; quad_index < quads; quad_index += 1)
+		{
+			const auto base = static_cast<T>(quad_index * 4);
+			indices.emplace_back(static_cast<T>(base + 0));
+			indices.emplace_back(static_cast<T>(base + 1));
+			indices.emplace_back(static_cast<T>(base + 2));
+
+			indices.emplace_back(static_cast<T>(base + 2));
+			indices.emplace_back(static_cast<T>(base + 3));
+			indices.emplace_back(static_cast<T>(base + 0));
+		}
+
+		ASSERT(6 * Cint_to_sizet(quads) == indices.size());
+		return indices;
+	}
+
+	template<typename T>
+	void upload_quad_indices(int quads)
+	{
+		const auto indices = create_quad_indices<T>(quads);
+		glBufferData(
+			GL_ELEMENT_ARRAY_BUFFER,
+			Csizet_to_glsizeiptr(indices.size() * sizeof(T)),
+			indices.data(),
+			GL_STATIC_DRAW
+		);
+	}
+
+	int get_supported_texture_slots(const BatchSettings& settings)
+	{
+		if (settings.multi_texture == false)
+		{
+			return 1;
+		}
+
+		int units = 1;
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+		return std::clamp(units, 1, SpriteBatch::max_texture_slots);
+	}
+
+	// the tile shader needs a unit for the animations after the batch textures, the static quads
+	// only use the first slot so the tile shader can have one slot less than the batch
+	int get_tile_texture_slots(int texture_slots)
+	{
+		if (texture_slots == 1)
+		{
+			return 1;
+		}
+
+		int units = 16;
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+
+		// opengl supports at least 16 units so the shader always keeps the slot attribute
+		return std::clamp(units - 1, 2, texture_slots);
+	}
+
+	ShaderVertexAttributes create_quad_description(int texture_slots)
+	{
+		auto description = ShaderVertexAttributes{
+			{VertexType::position2, "position"},
+			{VertexType::color4, "color"},
+			{VertexType::texture2, "uv"}
+		};
+		if (texture_slots > 1)
+		{
+			description.push_back({VertexType::texture_slot1, "slot"});
+		}
+		return description;
+	}
+
+	std::string create_quad_vertex_source(int texture_slots)
+	{
+		const auto multi_texture = texture_slots > 1;
+		return std::string{R"glsl(
+				#version 430 core
+				// vec4 so both the vec3 and the packed vec2 position work
+				in vec4 position;
+				in vec4 color;
+				in vec2 uv;
+				)glsl"}
+			 + (multi_texture ? "in uint slot;\nflat out uint varying_slot;\n" : "")
+			 + R"glsl(
+
+				uniform mat4 view_projection;
+				uniform mat4 transform;
+
+				out vec4 varying_color;
+				out vec2 varying_uv;
+
+				void main()
+				{
+					varying_color = color;
+					varying_uv = uv;
+					gl_Position = view_projection * transform * position;
+				)glsl"
+			 + (multi_texture ? "varying_slot = slot;\n" : "") + "}\n";
+	}
+
+	// the static quads use the quad attributes with the animation in a buffer of its own
+	ShaderVertexAttributes create_tile_description(int texture_slots)
+	{
+		auto description = create_quad_description(texture_slots);
+		description.push_back({VertexType::animation1, "animation"});
+		return description;
+	}
+
+	std::string create_tile_vertex_source(int texture_slots)
+	{
+		const auto multi_texture = texture_slots > 1;
+		return std::string{R"glsl(
+				#version 430 core
+				in vec4 position;
+				in vec4 color;
+				in vec2 uv;
+				// 0 if not animated, otherwise the row in the animations texture + 1
+				in uint animation;
+				)glsl"}
+			 + (multi_texture ? "in uint slot;\nflat out uint varying_slot;\n" : "")
+			 + R"glsl(
+
+				uniform mat4 view_projection;
+				uniform mat4 transform;
+
+				// one animation per row: (frame count, total duration) followed by
+				// one (uv offset, end time) per frame
+				uniform sampler2D animations;
+				uniform float time;
+
+				out vec4 varying_color;
+				out vec2 varying_uv;
+
+				vec2 get_uv_offset()
+				{
+					if (animation == 0u)
+					{
+						return vec2(0.0);
+					}
+
+					int row = int(animation - 1u);
+					vec4 header = texelFetch(animations, ivec2(0, row), 0);
+					float t = mod(time, header.y);
+					int frames = int(header.x);
+					for (int frame_index = 1; frame_index < frames; frame_index += 1)
+					{
+						vec4 frame = texelFetch(animations, ivec2(frame_index, row), 0);
+						if (t < frame.z)
+						{
+							return frame.xy;
+						}
+					}
+					return texelFetch(animations, ivec2(frames, row), 0).xy;
+				}
+
+				void main()
+				{
+					varying_color = color;
+					varying_uv = uv + get_uv_offset();
+					gl_Position = view_projection * transform * position;
+				)glsl"
+			 + (multi_texture ? "varying_slot = slot;\n" : "") + "}\n";
+	}
+
+	ShaderVertexAttributes create_sprite_description(int texture_slots)
+	{
+		auto description = ShaderVertexAttributes{
+			{VertexType::rect4, "rect"},
+			{VertexType::color4, "color"},
+			{VertexType::texture_rect4, "uv_rect"}
+		};
+		if (texture_slots > 1)
+		{
+			description.push_back({VertexType::texture_slot1, "slot"});
+		}
+		return description;
+	}
+
+	std::string create_sprite_vertex_source(int texture_slots)
+	{
+		const auto multi_texture = texture_slots > 1;
+		return std::string{R"glsl(
+				#version 430 core
+				// left, bottom, right, top
+				in vec4 rect;
+				in vec4 color;
+				in vec4 uv_rect;
+				)glsl"}
+			 + (multi_texture ? "in uint slot;\nflat out uint varying_slot;\n" : "")
+			 + R"glsl(
+
+				uniform mat4 view_projection;
+				uniform mat4 transform;
+
+				out vec4 varying_color;
+				out vec2 varying_uv;
+
+				void main()
+				{
+					// the quad indices are 0-3: left bottom, right bottom, right top and left top
+					bool right = gl_VertexID == 1 || gl_VertexID == 2;
+					bool top = gl_VertexID >= 2;
+
+					vec2 position = vec2(right ? rect.z : rect.x, top ? rect.w : rect.y);
+
+					varying_color = color;
+					varying_uv = vec2(right ? uv_rect.z : uv_rect.x, top ? uv_rect.w : uv_rect.y);
+					gl_Position = view_projection * transform * vec4(position, 0.0, 1.0);
+				)glsl"
+			 + (multi_texture ? "varying_slot = slot;\n" : "") + "}\n";
+	}
+
+	std::string create_quad_fragment_source(int texture_slots)
+	{
+		if (texture_slots == 1)
+		{
+			return R"glsl(
+				#version 430 core
+
+				in vec4 varying_color;
+				in vec2 varying_uv;
+
+				uniform sampler2D uniform_texture;
+
+				out vec4 color;
+
+				void main()
+				{
+					color = texture(uniform_texture, varying_uv) * varying_color;
+				}
+			)glsl";
+		}
+
+		// indexing a sampler array with a varying is undefined so select the sampler with a switch
+		std::string cases;
+		for (int slot = 0; slot < texture_slots; slot += 1)
+		{
+			cases += fmt::format(
+				"case {0}u: return texture(uniform_textures[{0}], varying_uv);\n", slot
+			);
+		}
+
+		return std::string{R"glsl(
+				#version 430 core
+
+				in vec4 varying_color;
+				in vec2 varying_uv;
+				flat in uint varying_slot;
+
+				uniform sampler2D uniform_textures[)glsl"}
+			 + std::to_string(texture_slots) + R"glsl(];
+
+				out vec4 color;
+
+				vec4 sample_texture()
+				{
+					switch (varying_slot)
+					{
+				)glsl"
+			 + cases + R"glsl(
+					default: return vec4(1.0);
+					}
+				}
+
+				void main()
+				{
+					color = sample_texture() * varying_color;
+				}
+			)glsl";
+	}
+
+	std::vector<Uniform> get_texture_uniforms(const ShaderProgram& shader, int texture_slots)
+	{
+		if (texture_slots == 1)
+		{
+			return {shader.get_uniform("uniform_texture")};
+		}
+
+		std::vector<Uniform> uniforms;
+		for (int slot = 0; slot < texture_slots; slot += 1)
+		{
+			uniforms.emplace_back(shader.get_uniform(fmt::format("uniform_textures[{}]", slot)));
+		}
+		return uniforms;
+	}
+
+	std::vector<Uniform*> get_uniform_pointers(std::vector<Uniform>* uniforms)
+	{
+		std::vector<Uniform*> pointers;
+		for (auto& uniform: *uniforms)
+		{
+			pointers.emplace_back(&uniform);
+		}
+		return pointers;
+	}
+
+	/** The gpu buffers of a StaticQuads */
+	struct StaticBuffers
+	{
+		u32 va;
+		u32 vb;
+		u32 animation_vb;  // one animation per vertex
+		u32 ib;
+		int quads = 0;
+		int indexed_quads = 0;	// number of quads the index buffer is sized for
+	};
+
+	struct OpenglBackend : Backend
+	{
+		OpenglStates* states;
+
+		VertexUpload upload;
+		VertexFormat format;
+		bool multi_texture;
+		bool small_indices;	 // u16 indices if max_quads allow it, u32 otherwise
+		int texture_slots;
+		int tile_texture_slots;	 // one less than the batch if needed to fit the animations
+
+		ShaderVertexAttributes quad_description;
+		ShaderVertexAttributes sprite_description;
+		ShaderVertexAttributes tile_description;
+		CompiledVertexTypeList attribute_layouts;  // shared by the quad, sprite and tile shaders
+
+		CompiledShaderVertexAttributes quad_layout;
+		ShaderProgram quad_shader;
+		Uniform view_projection_uniform;
+		Uniform transform_uniform;
+		std::vector<Uniform> texture_uniforms;	// one per texture slot
+
+		// draws the static quads and animates the uvs
+		CompiledShaderVertexAttributes tile_layout;
+		ShaderProgram tile_shader;
+		Uniform tile_view_projection_uniform;
+		Uniform tile_transform_uniform;
+		std::vector<Uniform> tile_texture_uniforms;
+		Uniform tile_animations_uniform;
+		Uniform tile_time_uniform;
+
+		// expands one instance per sprite
+		CompiledShaderVertexAttributes sprite_layout;
+		ShaderProgram sprite_shader;
+		Uniform sprite_view_projection_uniform;
+		Uniform sprite_transform_uniform;
+		std::vector<Uniform> sprite_texture_uniforms;
+
+		u32 va;
+		u32 vb;
+		u32 ib;
+		u32 sprite_va;
+		u32 sprite_vb;
+
+		int allocated_quads = 0;  // number of quads the gpu buffers are sized for
+		int ring_regions = 0;
+		int ring_index = 0;
+		std::vector<GLsync> ring_fences;  // null if the region isn't in use, one per region
+
+		std::map<u32, StaticBuffers> static_buffers;  // the key is the vertex array
+		std::vector<u32> animation_textures;
+
+		std::vector<GLuint> timestamp_queries;	// all created queries
+		std::vector<GLuint> free_timestamp_queries;
+
+		OpenglBackend(OpenglStates* s, const BatchSettings& settings);
+		~OpenglBackend() override;
+
+		int get_texture_slots() const override;
+		Texture create_white_texture() override;
+		void set_viewport(const Recti& screen) override;
+		void set_2d() override;
+		void clear(const glm::vec3& color) override;
+		void set_view_projection(const glm::mat4& view_projection) override;
+		void set_transform(const glm::mat4& transform) override;
+		void draw(const BatchDraw& batch, BatchStats* stats) override;
+		u32 create_static_quads() override;
+		void destroy_static_quads(u32 id) override;
+		void upload_static_quads(u32 id, const StaticUpload& upload) override;
+		void draw_static_quads(u32 id, const StaticDraw& draw, BatchStats* stats) override;
+		u32 create_animations(const std::vector<TileAnimation>& animations) override;
+		void destroy_animations(u32 id) override;
+		std::optional<u32> add_gpu_timestamp() override;
+		std::optional<u64> get_gpu_timestamp(u32 query) override;
+	};
+
+	std::size_t get_region_size(const OpenglBackend& backend)
+	{
+		return get_vertex_size(backend.format, backend.multi_texture) * 4
+			 * Cint_to_sizet(backend.allocated_quads);
+	}
+
+	void delete_ring_fences(OpenglBackend* backend)
+	{
+		for (auto fence: backend->ring_fences)
+		{
+			if (fence != nullptr)
+			{
+				glDeleteSync(fence);
+			}
+		}
+		backend->ring_fences.clear();
+	}
+
+	// (re)create the gpu buffers so they can hold the capacity
+	void allocate_buffers(OpenglBackend* backend, int capacity)
+	{
+		backend->allocated_quads = capacity;
+
+		// reallocating the storage orphans the old one, so the old fences are no longer needed
+		delete_ring_fences(backend);
+		backend->ring_index = 0;
+		backend->ring_regions = 1;
+		if (backend->upload == VertexUpload::ring)
+		{
+			const auto quads = backend->allocated_quads;
+			backend->ring_regions = std::max(min_ring_regions, (ring_quads + quads - 1) / quads);
+			backend->ring_fences.resize(Cint_to_sizet(backend->ring_regions), nullptr);
+		}
+
+		glBindVertexArray(backend->va);
+
+		glBindBuffer(GL_ARRAY_BUFFER, backend->vb);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			Csizet_to_glsizeiptr(get_region_size(*backend) * Cint_to_sizet(backend->ring_regions)),
+			nullptr,
+			backend->upload == VertexUpload::sub_data ? GL_DYNAMIC_DRAW : GL_STREAM_DRAW
+		);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, backend->ib);
+		if (backend->small_indices)
+		{
+			upload_quad_indices<u16>(backend->allocated_quads);
+		}
+		else
+		{
+			upload_quad_indices<u32>(backend->allocated_quads);
+		}
+	}
+
+	// wait until the gpu has stopped reading from the region, returns true if we had to wait
+	bool wait_for_region(OpenglBackend* backend, std::size_t region)
+	{
+		auto fence = backend->ring_fences[region];
+		if (fence == nullptr)
+		{
+			return false;
+		}
+
+		auto status = glClientWaitSync(fence, 0, 0);
+		const auto stalled = status == GL_TIMEOUT_EXPIRED;
+		while (status == GL_TIMEOUT_EXPIRED)
+		{
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fence_timeout_ns);
+		}
+
+		glDeleteSync(fence);
+		backend->ring_fences[region] = nullptr;
+		return stalled;
+	}
+
+	void draw_quads(OpenglBackend* backend, int quads, GLint base_vertex, BatchStats* stats)
+	{
+		glDrawElementsBaseVertex(
+			GL_TRIANGLES,
+			6 * quads,
+			backend->small_indices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+			nullptr,
+			base_vertex
+		);
+
+		stats->draw_calls += 1;
+		stats->quads += quads;
+	}
+
+	void submit_to_ring(OpenglBackend* backend, const BatchDraw& batch, BatchStats* stats)
+	{
+		const auto region = Cint_to_sizet(backend->ring_index);
+		if (wait_for_region(backend, region))
+		{
+			stats->stalls += 1;
+		}
+
+		// the fence guarantees the region isn't in use so skip the driver sync
+		const auto size = Csizet_to_glsizeiptr(batch.size);
+		const auto offset = static_cast<GLintptr>(region * get_region_size(*backend));
+		void* target = glMapBufferRange(
+			GL_ARRAY_BUFFER,
+			offset,
+			size,
+			GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+		);
+		if (target != nullptr)
+		{
+			std::memcpy(target, batch.data, batch.size);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+		else
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, offset, size, batch.data);
+		}
+
+		draw_quads(backend, batch.count, backend->ring_index * 4 * backend->allocated_quads, stats);
+		backend->ring_fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		backend->ring_index = (backend->ring_index + 1) % backend->ring_regions;
+	}
+
+	void submit_quads(OpenglBackend* backend, const BatchDraw& batch, BatchStats* stats)
+	{
+		if (backend->allocated_quads < batch.capacity)
+		{
+			allocate_buffers(backend, batch.capacity);
+		}
+
+		backend->quad_shader.use();
+		glBindVertexArray(backend->va);
+
+		glBindBuffer(GL_ARRAY_BUFFER, backend->vb);
+
+		const auto size = Csizet_to_glsizeiptr(batch.size);
+
+		switch (backend->upload)
+		{
+		case VertexUpload::sub_data:
+			glBufferSubData(GL_ARRAY_BUFFER, 0, size, batch.data);
+			draw_quads(backend, batch.count, 0, stats);
+			break;
+		case VertexUpload::orphan:
+			glBufferData(
+				GL_ARRAY_BUFFER,
+				Csizet_to_glsizeiptr(get_region_size(*backend)),
+				nullptr,
+				GL_STREAM_DRAW
+			);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, size, batch.data);
+			draw_quads(backend, batch.count, 0, stats);
+			break;
+		case VertexUpload::ring: submit_to_ring(backend, batch, stats); break;
+		}
+	}
+
+	void submit_sprites(OpenglBackend* backend, const BatchDraw& batch, BatchStats* stats)
+	{
+		backend->sprite_shader.use();
+		glBindVertexArray(backend->sprite_va);
+
+		// the instance data is small so always give the driver a new store to orphan the old one
+		glBindBuffer(GL_ARRAY_BUFFER, backend->sprite_vb);
+		glBufferData(GL_ARRAY_BUFFER, Csizet_to_glsizeiptr(batch.size), batch.data, GL_STREAM_DRAW);
+
+		glDrawElementsInstanced(
+			GL_TRIANGLES,
+			6,
+			backend->small_indices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+			nullptr,
+			batch.count
+		);
+
+		stats->draw_calls += 1;
+		stats->quads += batch.count;
+	}
+
+	OpenglBackend::OpenglBackend(OpenglStates* s, const BatchSettings& settings)
+		: states(s)
+		, upload(settings.upload)
+		, format(settings.format)
+		, multi_texture(settings.multi_texture)
+		, small_indices(std::max(1, settings.max_quads) <= max_small_index_quads)
+		, texture_slots(get_supported_texture_slots(settings))
+		, tile_texture_slots(get_tile_texture_slots(texture_slots))
+		, quad_description(create_quad_description(texture_slots))
+		, sprite_description(create_sprite_description(texture_slots))
+		, tile_description(create_tile_description(texture_slots))
+		, attribute_layouts(compile_attribute_layouts(
+			  {quad_description, sprite_description, tile_description}
+		  ))
+		, quad_layout(compile_shader_layout(attribute_layouts, quad_description))
+		, quad_shader(
+			  create_quad_vertex_source(texture_slots),
+			  create_quad_fragment_source(texture_slots),
+			  quad_layout
+		  )
+		, view_projection_uniform(quad_shader.get_uniform("view_projection"))
+		, transform_uniform(quad_shader.get_uniform("transform"))
+		, texture_uniforms(get_texture_uniforms(quad_shader, texture_slots))
+		, tile_layout(compile_shader_layout(attribute_layouts, tile_description))
+		, tile_shader(
+			  create_tile_vertex_source(texture_slots),
+			  create_quad_fragment_source(tile_texture_slots),
+			  tile_layout
+		  )
+		, tile_view_projection_uniform(tile_shader.get_uniform("view_projection"))
+		, tile_transform_uniform(tile_shader.get_uniform("transform"))
+		, tile_texture_uniforms(get_texture_uniforms(tile_shader, tile_texture_slots))
+		, tile_animations_uniform(tile_shader.get_uniform("animations"))
+		, tile_time_uniform(tile_shader.get_uniform("time"))
+		, sprite_layout(compile_shader_layout(attribute_layouts, sprite_description))
+		, sprite_shader(
+			  create_sprite_vertex_source(texture_slots),
+			  create_quad_fragment_source(texture_slots),
+			  sprite_layout
+		  )
+		, sprite_view_projection_uniform(sprite_shader.get_uniform("view_projection"))
+		, sprite_transform_uniform(sprite_shader.get_uniform("transform"))
+		, sprite_texture_uniforms(get_texture_uniforms(sprite_shader, texture_slots))
+	{
+		// both shaders get the same texture units so the textures can be bound for either
+		setup_textures(&sprite_shader, get_uniform_pointers(&sprite_texture_uniforms));
+		setup_textures(&quad_shader, get_uniform_pointers(&texture_uniforms));
+
+		// the animations use the unit after the batch textures
+		auto tile_textures = get_uniform_pointers(&tile_texture_uniforms);
+		tile_textures.emplace_back(&tile_animations_uniform);
+		setup_textures(&tile_shader, tile_textures);
+
+		glGenVertexArrays(1, &va);
+		glBindVertexArray(va);
+
+		glGenBuffers(1, &vb);
+		glBindBuffer(GL_ARRAY_BUFFER, vb);
+
+		setup_vertex_attributes(quad_layout, format, multi_texture);
+
+		glGenBuffers(1, &ib);
+
+		allocate_buffers(this, std::clamp(settings.quads, 1, std::max(1, settings.max_quads)));
+
+		// the sprites share the index buffer, only the first quad is used
+		glGenVertexArrays(1, &sprite_va);
+		glBindVertexArray(sprite_va);
+
+		glGenBuffers(1, &sprite_vb);
+		glBindBuffer(GL_ARRAY_BUFFER, sprite_vb);
+
+		setup_sprite_attributes(sprite_layout, format, multi_texture);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib);
+	}
+
+	OpenglBackend::~OpenglBackend()
+	{
+		delete_ring_fences(this);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &ib);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &vb);
+
+		glBindVertexArray(0);
+		glDeleteVertexArrays(1, &va);
+
+		glDeleteBuffers(1, &sprite_vb);
+		glDeleteVertexArrays(1, &sprite_va);
+
+		for (auto& [id, buffers]: static_buffers)
+		{
+			glDeleteBuffers(1, &buffers.ib);
+			glDeleteBuffers(1, &buffers.animation_vb);
+			glDeleteBuffers(1, &buffers.vb);
+			glDeleteVertexArrays(1, &buffers.va);
+		}
+
+		for (auto texture: animation_textures)
+		{
+			glDeleteTextures(1, &texture);
+		}
+
+		if (timestamp_queries.empty() == false)
+		{
+			glDeleteQueries(Csizet_to_glsizei(timestamp_queries.size()), timestamp_queries.data());
+		}
+	}
+
+	int OpenglBackend::get_texture_slots() const
+	{
+		return texture_slots;
+	}
+
+	Texture OpenglBackend::create_white_texture()
+	{
+		return load_image_from_color(
+			0xffffffff, TextureEdge::clamp, TextureRenderStyle::pixel, Transparency::include
+		);
+	}
+
+	void OpenglBackend::set_viewport(const Recti& screen)
+	{
+		set_gl_viewport(screen);
+	}
+
+	void OpenglBackend::set_2d()
+	{
+		opengl_set2d(states);
+	}
+
+	void OpenglBackend::clear(const glm::vec3& color)
+	{
+		glClearColor(color.r, color.g, color.b, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+
+	void OpenglBackend::set_view_projection(const glm::mat4& view_projection)
+	{
+		tile_shader.use();
+		tile_shader.set_mat(tile_view_projection_uniform, view_projection);
+
+		sprite_shader.use();
+		sprite_shader.set_mat(sprite_view_projection_uniform, view_projection);
+
+		quad_shader.use();
+		quad_shader.set_mat(view_projection_uniform, view_projection);
+	}
+
+	void OpenglBackend::set_transform(const glm::mat4& transform)
+	{
+		tile_shader.use();
+		tile_shader.set_mat(tile_transform_uniform, transform);
+
+		sprite_shader.use();
+		sprite_shader.set_mat(sprite_transform_uniform, transform);
+
+		quad_shader.use();
+		quad_shader.set_mat(transform_uniform, transform);
+	}
+
+	void OpenglBackend::draw(const BatchDraw& batch, BatchStats* stats)
+	{
+		const auto& textures = *batch.textures;
+		for (std::size_t slot = 0; slot < textures.size(); slot += 1)
+		{
+			bind_texture(texture_uniforms[slot], *textures[slot]);
+		}
+
+		switch (batch.content)
+		{
+		case BatchContent::quads: submit_quads(this, batch, stats); break;
+		case BatchContent::sprites: submit_sprites(this, batch, stats); break;
+		}
+	}
+
+	u32 OpenglBackend::create_static_quads()
+	{
+		auto buffers = StaticBuffers{};
+
+		glGenVertexArrays(1, &buffers.va);
+		glBindVertexArray(buffers.va);
+
+		glGenBuffers(1, &buffers.vb);
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.vb);
+		setup_vertex_attributes(quad_layout, format, multi_texture);
+
+		const auto& animation_element = tile_layout.elements.back();
+		ASSERT(animation_element.type == VertexType::animation1);
+		const auto animation_index = Cint_to_gluint(animation_element.index);
+		glGenBuffers(1, &buffers.animation_vb);
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.animation_vb);
+		glEnableVertexAttribArray(animation_index);
+		glVertexAttribIPointer(animation_index, 1, GL_UNSIGNED_INT, sizeof(u32), nullptr);
+
+		glGenBuffers(1, &buffers.ib);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.ib);
+
+		glBindVertexArray(0);
+
+		static_buffers.emplace(buffers.va, buffers);
+		return buffers.va;
+	}
+
+	void OpenglBackend::destroy_static_quads(u32 id)
+	{
+		auto found = static_buffers.find(id);
+		ASSERT(found != static_buffers.end());
+		auto& buffers = found->second;
+
+		glDeleteBuffers(1, &buffers.ib);
+		glDeleteBuffers(1, &buffers.animation_vb);
+		glDeleteBuffers(1, &buffers.vb);
+		glDeleteVertexArrays(1, &buffers.va);
+
+		static_buffers.erase(found);
+	}
+
+	void OpenglBackend::upload_static_quads(u32 id, const StaticUpload& upload)
+	{
+		auto& buffers = static_buffers.at(id);
+		const auto quads = upload.quads;
+		buffers.quads = quads;
+
+		glBindVertexArray(buffers.va);
+
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.vb);
+		glBufferData(GL_ARRAY_BUFFER, Csizet_to_glsizeiptr(upload.size), upload.data, GL_STATIC_DRAW);
+
+		ASSERT(upload.animations->size() == 4 * Cint_to_sizet(quads));
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.animation_vb);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			Csizet_to_glsizeiptr(upload.animations->size() * sizeof(u32)),
+			upload.animations->data(),
+			GL_STATIC_DRAW
+		);
+
+		// the indices only depend on the number of quads so only grow them
+		if (buffers.indexed_quads < quads)
+		{
+			buffers.indexed_quads = quads;
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.ib);
+			if (quads <= max_small_index_quads)
+			{
+				upload_quad_indices<u16>(quads);
+			}
+			else
+			{
+				upload_quad_indices<u32>(quads);
+			}
+		}
+
+		glBindVertexArray(0);
+	}
+
+	void OpenglBackend::draw_static_quads(u32 id, const StaticDraw& draw, BatchStats* stats)
+	{
+		const auto& buffers = static_buffers.at(id);
+		if (buffers.quads == 0)
+		{
+			return;
+		}
+
+		tile_shader.use();
+		bind_texture(tile_texture_uniforms[0], *draw.texture);
+		if (draw.animations != 0)
+		{
+			glActiveTexture(Cint_to_glenum(GL_TEXTURE0 + tile_animations_uniform.texture));
+			glBindTexture(GL_TEXTURE_2D, draw.animations);
+			tile_shader.set_float(tile_time_uniform, draw.time);
+		}
+
+		glBindVertexArray(buffers.va);
+		glDrawElements(
+			GL_TRIANGLES,
+			6 * buffers.quads,
+			buffers.indexed_quads <= max_small_index_quads ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+			nullptr
+		);
+		glBindVertexArray(0);
+
+		stats->draw_calls += 1;
+		stats->quads += buffers.quads;
+	}
+
+	u32 OpenglBackend::create_animations(const std::vector<TileAnimation>& animations)
+	{
+		std::size_t max_frames = 0;
+		for (const auto& animation: animations)
+		{
+			max_frames = std::max(max_frames, animation.frames.size());
+		}
+
+		// see create_tile_vertex_source for the layout
+		const auto width = max_frames + 1;
+		const auto height = std::max<std::size_t>(1, animations.size());
+		std::vector<glm::vec4> texels(width * height, glm::vec4{0.0f});
+		for (std::size_t row = 0; row < animations.size(); row += 1)
+		{
+			const auto& frames = animations[row].frames;
+			float end = 0.0f;
+			for (std::size_t frame = 0; frame < frames.size(); frame += 1)
+			{
+				end += frames[frame].duration;
+				texels[row * width + frame + 1]
+					= glm::vec4{frames[frame].uv_offset.x, frames[frame].uv_offset.y, end, 0.0f};
+			}
+			texels[row * width]
+				= glm::vec4{static_cast<float>(frames.size()), std::max(end, 0.001f), 0.0f, 0.0f};
+		}
+
+		GLuint texture = 0;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			0,
+			GL_RGBA32F,
+			Csizet_to_glsizei(width),
+			Csizet_to_glsizei(height),
+			0,
+			GL_RGBA,
+			GL_FLOAT,
+			texels.data()
+		);
+
+		animation_textures.emplace_back(texture);
+		return texture;
+	}
+
+	void OpenglBackend::destroy_animations(u32 id)
+	{
+		auto found = std::find(animation_textures.begin(), animation_textures.end(), id);
+		ASSERT(found != animation_textures.end());
+		animation_textures.erase(found);
+		glDeleteTextures(1, &id);
+	}
+
+	std::optional<u32> OpenglBackend::add_gpu_timestamp()
+	{
+		// timer queries are core since 3.3
+		if (GLAD_GL_VERSION_3_3 == 0)
+		{
+			return std::nullopt;
+		}
+
+		if (free_timestamp_queries.empty())
+		{
+			GLuint query = 0;
+			glGenQueries(1, &query);
+			timestamp_queries.emplace_back(query);
+			free_timestamp_queries.emplace_back(query);
+		}
+
+		const auto query = free_timestamp_queries.back();
+		free_timestamp_queries.pop_back();
+		glQueryCounter(query, GL_TIMESTAMP);
+		return query;
+	}
+
+	std::optional<u64> OpenglBackend::get_gpu_timestamp(u32 query)
+	{
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+		{
+			return std::nullopt;
+		}
+
+		GLuint64 timestamp = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &timestamp);
+		free_timestamp_queries.emplace_back(query);
+		return timestamp;
+	}
+}  //  namespace
+
+std::unique_ptr<Backend> create_opengl_backend(OpenglStates* states, const BatchSettings& settings)
+{
+	return std::make_unique<OpenglBackend>(states, settings);
+}
+
+}  //  namespace render
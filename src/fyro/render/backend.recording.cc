@@ -0,0 +1,261 @@
+#include "fyro/render/backend.recording.h"
+
+#include <fmt/ranges.h>
+
+#include "fyro/assert.h"
+#include "fyro/cint.h"
+#include "fyro/render/render2.h"
+#include "fyro/render/texture.h"
+
+namespace render
+{
+
+namespace
+{
+	// fnv-1a, stable between runs and platforms so it can be stored in golden files
+	u64 hash_bytes(const u8* data, std::size_t size, u64 hash = 14695981039346656037ull)
+	{
+		for (std::size_t index = 0; index < size; index += 1)
+		{
+			hash ^= data[index];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	std::vector<float> get_values(const glm::mat4& m)
+	{
+		std::vector<float> values;
+		for (int column = 0; column < 4; column += 1)
+		{
+			for (int row = 0; row < 4; row += 1)
+			{
+				values.emplace_back(m[column][row]);
+			}
+		}
+		return values;
+	}
+
+	RecordedCommand create_command(RecordedCommandType type, std::vector<float> values = {})
+	{
+		auto command = RecordedCommand{};
+		command.type = type;
+		command.values = std::move(values);
+		return command;
+	}
+
+	std::string_view get_name(RecordedCommandType type)
+	{
+		switch (type)
+		{
+		case RecordedCommandType::set_viewport: return "viewport";
+		case RecordedCommandType::set_2d: return "set_2d";
+		case RecordedCommandType::clear: return "clear";
+		case RecordedCommandType::set_view_projection: return "view_projection";
+		case RecordedCommandType::set_transform: return "transform";
+		case RecordedCommandType::draw: return "draw";
+		case RecordedCommandType::upload_static: return "upload_static";
+		case RecordedCommandType::draw_static: return "draw_static";
+		case RecordedCommandType::create_animations: return "create_animations";
+		default: return "<unknown>";
+		}
+	}
+}  //  namespace
+
+RecordingBackend::RecordingBackend(int slots, bool payload)
+	: texture_slots(std::clamp(slots, 1, SpriteBatch::max_texture_slots))
+	, record_payload(payload)
+{
+}
+
+int RecordingBackend::get_texture_slots() const
+{
+	return texture_slots;
+}
+
+Texture RecordingBackend::create_white_texture()
+{
+	// there is nothing to upload to, so use a invalid texture
+	return Texture{};
+}
+
+void RecordingBackend::set_viewport(const Recti& screen)
+{
+	commands.emplace_back(create_command(
+		RecordedCommandType::set_viewport,
+		{static_cast<float>(screen.left),
+		 static_cast<float>(screen.bottom),
+		 static_cast<float>(screen.right),
+		 static_cast<float>(screen.top)}
+	));
+}
+
+void RecordingBackend::set_2d()
+{
+	commands.emplace_back(create_command(RecordedCommandType::set_2d));
+}
+
+void RecordingBackend::clear(const glm::vec3& color)
+{
+	commands.emplace_back(create_command(RecordedCommandType::clear, {color.r, color.g, color.b}));
+}
+
+void RecordingBackend::set_view_projection(const glm::mat4& view_projection)
+{
+	commands.emplace_back(
+		create_command(RecordedCommandType::set_view_projection, get_values(view_projection))
+	);
+}
+
+void RecordingBackend::set_transform(const glm::mat4& transform)
+{
+	commands.emplace_back(
+		create_command(RecordedCommandType::set_transform, get_values(transform))
+	);
+}
+
+void RecordingBackend::draw(const BatchDraw& batch, BatchStats* stats)
+{
+	auto command = create_command(RecordedCommandType::draw);
+	command.content = batch.content;
+	command.count = batch.count;
+	for (const auto* texture: *batch.textures)
+	{
+		command.textures.emplace_back(texture->id);
+	}
+	if (record_payload)
+	{
+		command.payload.assign(batch.data, batch.data + batch.size);
+	}
+	command.payload_hash = hash_bytes(batch.data, batch.size);
+	commands.emplace_back(std::move(command));
+
+	stats->draw_calls += 1;
+	stats->quads += batch.count;
+}
+
+u32 RecordingBackend::create_static_quads()
+{
+	const auto id = next_static_id;
+	next_static_id += 1;
+	static_quads[id] = 0;
+	return id;
+}
+
+void RecordingBackend::destroy_static_quads(u32 id)
+{
+	static_quads.erase(id);
+}
+
+void RecordingBackend::upload_static_quads(u32 id, const StaticUpload& upload)
+{
+	auto command = create_command(RecordedCommandType::upload_static);
+	command.static_id = id;
+	command.count = upload.quads;
+	if (record_payload)
+	{
+		command.payload.assign(upload.data, upload.data + upload.size);
+	}
+	command.payload_hash = hash_bytes(
+		reinterpret_cast<const u8*>(upload.animations->data()),
+		upload.animations->size() * sizeof(u32),
+		hash_bytes(upload.data, upload.size)
+	);
+	commands.emplace_back(std::move(command));
+
+	static_quads[id] = upload.quads;
+}
+
+void RecordingBackend::draw_static_quads(u32 id, const StaticDraw& draw, BatchStats* stats)
+{
+	auto command = create_command(RecordedCommandType::draw_static);
+	if (draw.animations != 0)
+	{
+		command.values = {static_cast<float>(draw.animations), draw.time};
+	}
+	command.static_id = id;
+	command.textures.emplace_back(draw.texture->id);
+	commands.emplace_back(std::move(command));
+
+	stats->draw_calls += 1;
+	stats->quads += static_quads[id];
+}
+
+u32 RecordingBackend::create_animations(const std::vector<TileAnimation>& animations)
+{
+	const auto id = next_animations_id;
+	next_animations_id += 1;
+
+	auto command = create_command(RecordedCommandType::create_animations);
+	command.static_id = id;
+	command.count = Csizet_to_int(animations.size());
+	for (const auto& animation: animations)
+	{
+		for (const auto& frame: animation.frames)
+		{
+			command.values.emplace_back(frame.uv_offset.x);
+			command.values.emplace_back(frame.uv_offset.y);
+			command.values.emplace_back(frame.duration);
+		}
+	}
+	commands.emplace_back(std::move(command));
+
+	return id;
+}
+
+void RecordingBackend::destroy_animations(u32)
+{
+}
+
+std::optional<u32> RecordingBackend::add_gpu_timestamp()
+{
+	// there is no gpu to time
+	return std::nullopt;
+}
+
+std::optional<u64> RecordingBackend::get_gpu_timestamp(u32)
+{
+	DIE("no gpu timestamps are handed out");
+	return std::nullopt;
+}
+
+std::string to_string(const std::vector<RecordedCommand>& commands)
+{
+	std::string r;
+	for (const auto& command: commands)
+	{
+		r += get_name(command.type);
+		for (const auto v: command.values)
+		{
+			r += fmt::format(" {}", v);
+		}
+		if (command.type == RecordedCommandType::draw)
+		{
+			r += fmt::format(
+				" {} {} textures [{}] payload {:016x}",
+				command.content == BatchContent::quads ? "quads" : "sprites",
+				command.count,
+				fmt::join(command.textures, " "),
+				command.payload_hash
+			);
+		}
+		else if (command.type == RecordedCommandType::upload_static)
+		{
+			r += fmt::format(
+				" {} {} payload {:016x}", command.static_id, command.count, command.payload_hash
+			);
+		}
+		else if (command.type == RecordedCommandType::create_animations)
+		{
+			r += fmt::format(" {} {}", command.static_id, command.count);
+		}
+		else if (command.type == RecordedCommandType::draw_static)
+		{
+			r += fmt::format(" {} textures [{}]", command.static_id, fmt::join(command.textures, " "));
+		}
+		r += "\n";
+	}
+	return r;
+}
+
+}  //  namespace render
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "fyro/render/backend.h"
+
+namespace render
+{
+
+enum class RecordedCommandType
+{
+	set_viewport,
+	set_2d,
+	clear,
+	set_view_projection,
+	set_transform,
+	draw,
+	upload_static,
+	draw_static,
+	create_animations
+};
+
+/** A single call to the RecordingBackend */
+struct RecordedCommand
+{
+	RecordedCommandType type;
+
+	/// the viewport (left, bottom, right, top), clear color, matrix or animation time
+	std::vector<float> values;
+
+	// only valid for draw, upload_static and draw_static
+	u32 static_id = 0;	// static and animation only
+	BatchContent content = BatchContent::quads;
+	int count = 0;
+	std::vector<unsigned int> textures;	 // texture ids, one per slot
+	std::vector<u8> payload;  // the vertex or instance data, if recorded
+	u64 payload_hash = 0;
+};
+
+/** A Backend that doesn't need a gpu, it captures all the calls in memory instead */
+struct RecordingBackend : Backend
+{
+	explicit RecordingBackend(int texture_slots = 1, bool record_payload = true);
+
+	int texture_slots;
+
+	/// false to only store the hash of the payload, keeps the memory down for long runs
+	bool record_payload;
+
+	std::vector<RecordedCommand> commands;
+	u32 next_static_id = 1;
+	u32 next_animations_id = 1;
+	std::unordered_map<u32, int> static_quads;	// number of uploaded quads for each static id
+
+	int get_texture_slots() const override;
+	Texture create_white_texture() override;
+	void set_viewport(const Recti& screen) override;
+	void set_2d() override;
+	void clear(const glm::vec3& color) override;
+	void set_view_projection(const glm::mat4& view_projection) override;
+	void set_transform(const glm::mat4& transform) override;
+	void draw(const BatchDraw& batch, BatchStats* stats) override;
+	u32 create_static_quads() override;
+	void destroy_static_quads(u32 id) override;
+	void upload_static_quads(u32 id, const StaticUpload& upload) override;
+	void draw_static_quads(u32 id, const StaticDraw& draw, BatchStats* stats) override;
+	u32 create_animations(const std::vector<TileAnimation>& animations) override;
+	void destroy_animations(u32 id) override;
+	std::optional<u32> add_gpu_timestamp() override;
+	std::optional<u64> get_gpu_timestamp(u32 query) override;
+};
+
+/// one line per command, meant to be compared against a golden command stream
+std::string to_string(const std::vector<RecordedCommand>& commands);
+
+}  //  namespace render
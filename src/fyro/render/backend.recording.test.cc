@@ -0,0 +1,123 @@
+#include "catch.hpp"
+
+#include "fyro/render/backend.recording.h"
+#include "fyro/render/quad_writer.h"
+#include "fyro/render/render2.h"
+#include "fyro/render/static_quads.h"
+
+using namespace render;
+
+namespace
+{
+	// the render takes ownership of the backend, so keep a pointer to read the commands
+	std::unique_ptr<Render2> create_render(RecordingBackend** backend, const BatchSettings& settings)
+	{
+		auto recording = std::make_unique<RecordingBackend>();
+		*backend = recording.get();
+		return std::make_unique<Render2>(std::move(recording), settings);
+	}
+}  //  namespace
+
+TEST_CASE("backend.recording: quads are drawn in a single call", "[backend]")
+{
+	RecordingBackend* backend = nullptr;
+	auto render = create_render(&backend, {});
+
+	render->set_view_projection(glm::mat4(1.0f));
+	render->batch.quadf(std::nullopt, {0.0f, 0.0f, 16.0f, 16.0f}, std::nullopt, false);
+	render->batch.quadf(std::nullopt, {16.0f, 0.0f, 32.0f, 16.0f}, std::nullopt, false);
+	render->batch.submit();
+
+	REQUIRE(backend->commands.size() == 2);
+	CHECK(backend->commands[0].type == RecordedCommandType::set_view_projection);
+
+	const auto& draw = backend->commands[1];
+	CHECK(draw.type == RecordedCommandType::draw);
+	CHECK(draw.content == BatchContent::quads);
+	CHECK(draw.count == 2);
+	CHECK(draw.payload.size() == 2 * 4 * get_vertex_size(VertexFormat::full, false));
+
+	CHECK(render->batch.current_frame.draw_calls == 1);
+	CHECK(render->batch.current_frame.quads == 2);
+}
+
+TEST_CASE("backend.recording: same input gives the same command stream", "[backend]")
+{
+	auto record = [](bool record_payload)
+	{
+		auto backend = std::make_unique<RecordingBackend>(1, record_payload);
+		auto* commands = &backend->commands;
+		auto render = Render2{std::move(backend), {}};
+		render.set_transform(glm::mat4(1.0f));
+		render.batch.quadf(
+			std::nullopt, {1.0f, 2.0f, 3.0f, 4.0f}, std::nullopt, true, glm::vec4{0.5f}
+		);
+		render.batch.submit();
+		return to_string(*commands);
+	};
+
+	const auto golden = record(true);
+	CHECK(golden == record(true));
+
+	// only storing the hash must not change the stream
+	CHECK(golden == record(false));
+}
+
+TEST_CASE("backend.recording: static quads are only uploaded when changed", "[backend]")
+{
+	RecordingBackend* backend = nullptr;
+	auto render = create_render(&backend, {});
+
+	const auto v = Vertex2{{0.0f, 0.0f}, glm::vec4{1.0f}, {0.0f, 0.0f}};
+	auto texture = Texture{};
+
+	auto geometry = StaticQuads{render.get()};
+	geometry.add(v, v, v, v);
+	geometry.add(v, v, v, v);
+
+	geometry.draw(&render->batch, texture);
+	geometry.draw(&render->batch, texture);
+
+	REQUIRE(backend->commands.size() == 3);
+	CHECK(backend->commands[0].type == RecordedCommandType::upload_static);
+	CHECK(backend->commands[0].count == 2);
+	CHECK(backend->commands[1].type == RecordedCommandType::draw_static);
+	CHECK(backend->commands[2].type == RecordedCommandType::draw_static);
+	CHECK(render->batch.current_frame.quads == 4);
+
+	geometry.clear();
+	geometry.add(v, v, v, v);
+	geometry.draw(&render->batch, texture);
+
+	REQUIRE(backend->commands.size() == 5);
+	CHECK(backend->commands[3].type == RecordedCommandType::upload_static);
+	CHECK(backend->commands[3].count == 1);
+}
+
+TEST_CASE("backend.recording: animated static quads are not uploaded when time changes", "[backend]")
+{
+	RecordingBackend* backend = nullptr;
+	auto render = create_render(&backend, {});
+
+	const auto v = Vertex2{{0.0f, 0.0f}, glm::vec4{1.0f}, {0.0f, 0.0f}};
+	auto texture = Texture{};
+
+	auto table = StaticAnimations{
+		render.get(), {TileAnimation{{{{0.0f, 0.0f}, 0.5f}, {{0.25f, 0.0f}, 0.5f}}}}
+	};
+	auto geometry = StaticQuads{render.get()};
+	geometry.add(v, v, v, v, 0);
+	geometry.add(v, v, v, v);
+	CHECK(geometry.animations == std::vector<u32>{1, 1, 1, 1, 0, 0, 0, 0});
+
+	geometry.draw(&render->batch, texture, &table, 0.0f);
+	geometry.draw(&render->batch, texture, &table, 0.75f);
+
+	REQUIRE(backend->commands.size() == 4);
+	CHECK(backend->commands[0].type == RecordedCommandType::create_animations);
+	CHECK(backend->commands[0].count == 1);
+	CHECK(backend->commands[1].type == RecordedCommandType::upload_static);
+	CHECK(backend->commands[2].type == RecordedCommandType::draw_static);
+	CHECK(backend->commands[3].type == RecordedCommandType::draw_static);
+	CHECK(backend->commands[3].values == std::vector<float>{static_cast<float>(table.id), 0.75f});
+}
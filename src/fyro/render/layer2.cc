@@ -2,8 +2,10 @@
 
 #include "fyro/dependencies/dependency_opengl.h"
 
+#include "fyro/render/backend.h"
 #include "fyro/render/opengl_utils.h"
 #include "fyro/render/render2.h"
+#include "fyro/render/sprite_queue.h"
 #include "fyro/render/viewportdef.h"
 
 namespace render
@@ -16,12 +18,69 @@ void set_gl_viewport(const Recti& r)
 
 RenderLayer2::~RenderLayer2()
 {
+	finish();
+}
+
+RenderLayer2::RenderLayer2(RenderLayer2&& rhs)
+	: Layer(rhs)
+	, batch(rhs.batch)
+	, timer(rhs.timer)
+{
+	rhs.batch = nullptr;
+	rhs.timer = -1;
+}
+
+void RenderLayer2::operator=(RenderLayer2&& rhs)
+{
+	finish();
+
+	viewport_aabb_in_worldspace = rhs.viewport_aabb_in_worldspace;
+	screen = rhs.screen;
+	batch = rhs.batch;
+	timer = rhs.timer;
+
+	rhs.batch = nullptr;
+	rhs.timer = -1;
+}
+
+void RenderLayer2::finish()
+{
+	if (batch == nullptr)
+	{
+		return;
+	}
+
+	if (batch->sorting)
+	{
+		batch->sorting = false;
+		batch->queue->flush(batch);
+	}
 	batch->submit();
+
+	batch->render->profiler.end(timer);
+	batch = nullptr;
+	timer = -1;
+}
+
+void RenderLayer2::start_sorting()
+{
+	batch->sorting = true;
+}
+
+void RenderLayer2::set_sort_layer(u8 layer)
+{
+	batch->queue->layer = layer;
 }
 
-RenderLayer2::RenderLayer2(Layer&& l, SpriteBatch* b)
+void RenderLayer2::set_depth(float depth)
+{
+	batch->queue->depth = depth;
+}
+
+RenderLayer2::RenderLayer2(Layer&& l, SpriteBatch* b, int t)
 	: Layer(l)
 	, batch(b)
+	, timer(t)
 {
 }
 
@@ -37,23 +96,26 @@ Layer create_layer(const ViewportDef& vp)
 
 RenderLayer2 create_layer2(const RenderCommand& rc, const ViewportDef& vp)
 {
-	set_gl_viewport(vp.screen_rect);
-	opengl_set2d(rc.states);
+	const auto timer
+		= rc.render->profiler.begin(fmt::format("layer {}", rc.render->layers), true);
+	rc.render->layers += 1;
+
+	rc.render->backend->set_viewport(vp.screen_rect);
+	rc.render->backend->set_2d();
 
 	const auto camera = glm::mat4(1.0f);
 	const auto projection = glm::ortho(0.0f, vp.virtual_width, 0.0f, vp.virtual_height);
 
-	rc.render->quad_shader.use();
-	rc.render->quad_shader.set_mat(rc.render->view_projection_uniform, projection);
+	rc.render->set_view_projection(projection);
 	rc.set_camera(camera);
 
 	// todo(Gustav): transform viewport according to the camera
-	return RenderLayer2{create_layer(vp), &rc.render->batch};
+	return RenderLayer2{create_layer(vp), &rc.render->batch, timer};
 }
 
 void RenderCommand::set_camera(const glm::mat4& camera) const
 {
-	render->quad_shader.set_mat(render->transform_uniform, camera);
+	render->set_transform(camera);
 }
 
 RenderLayer3 create_layer3(const RenderCommand& rc, const ViewportDef& vp)
@@ -87,8 +149,7 @@ void RenderCommand::clear(const glm::vec3& color, const LayoutData& ld) const
 {
 	if (ld.style == ViewportStyle::extended)
 	{
-		glClearColor(color.r, color.g, color.b, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
+		render->backend->clear(color);
 	}
 	else
 	{
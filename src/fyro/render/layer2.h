@@ -1,6 +1,7 @@
 #pragma once
 
 #include "fyro/rect.h"
+#include "fyro/types.h"
 
 namespace render
 {
@@ -19,11 +20,31 @@ struct Layer
 
 struct RenderLayer2 : Layer
 {
-	SpriteBatch* batch;
+	SpriteBatch* batch;	 // null if moved from
+	int timer;	// profiler scope of the layer
 
-	RenderLayer2(Layer&& l, SpriteBatch* batch);
+	RenderLayer2(Layer&& l, SpriteBatch* batch, int timer);
 
 	~RenderLayer2();
+
+	RenderLayer2(const RenderLayer2&) = delete;
+	void operator=(const RenderLayer2&) = delete;
+
+	// moving the layer transfers the pending quads and the timer
+	RenderLayer2(RenderLayer2&& rhs);
+	void operator=(RenderLayer2&& rhs);
+
+	/// draw the pending quads and stop the timer, called when the layer is destroyed
+	void finish();
+
+	/// record the following quads and draw them sorted by layer, depth and texture when done
+	void start_sorting();
+
+	/// layer of the following sorted quads, lower layers are drawn first
+	void set_sort_layer(u8 layer);
+
+	/// depth of the following sorted quads, higher depths are drawn first (further back)
+	void set_depth(float depth);
 };
 
 struct RenderLayer3 : Layer
@@ -0,0 +1,229 @@
+#include "fyro/render/profiler.h"
+
+#include "fyro/assert.h"
+#include "fyro/cint.h"
+#include "fyro/render/backend.h"
+
+namespace render
+{
+
+namespace
+{
+	int find_or_add_timer(Profiler* profiler, std::string_view name)
+	{
+		for (std::size_t index = 0; index < profiler->timers.size(); index += 1)
+		{
+			if (profiler->timers[index].name == name)
+			{
+				return Csizet_to_int(index);
+			}
+		}
+
+		profiler->timers.emplace_back();
+		profiler->timers.back().name = std::string{name};
+		return Csizet_to_int(profiler->timers.size() - 1);
+	}
+
+	void read_timestamp(Backend* backend, std::optional<u32>* query, u64* ns)
+	{
+		if (query->has_value() == false)
+		{
+			return;
+		}
+
+		if (const auto timestamp = backend->get_gpu_timestamp(**query); timestamp)
+		{
+			*ns = *timestamp;
+			query->reset();
+		}
+	}
+
+	// read all the available timestamps, returns true if the gpu is done with the frame
+	bool read_timestamps(Backend* backend, PendingFrame* frame)
+	{
+		bool ready = true;
+		for (auto& scope: frame->scopes)
+		{
+			read_timestamp(backend, &scope.gpu_start_query, &scope.gpu_start_ns);
+			read_timestamp(backend, &scope.gpu_end_query, &scope.gpu_end_ns);
+			if (scope.gpu_start_query || scope.gpu_end_query)
+			{
+				ready = false;
+			}
+		}
+		return ready;
+	}
+
+	/** The sum of all scopes of a single timer in a single frame */
+	struct FrameTotal
+	{
+		int calls = 0;
+		float cpu_ms = 0.0f;
+		float gpu_ms = 0.0f;
+		bool gpu = false;
+	};
+
+	void add_frame(Profiler* profiler, const PendingFrame& frame)
+	{
+		std::vector<FrameTotal> totals(profiler->timers.size());
+		for (const auto& scope: frame.scopes)
+		{
+			auto& total = totals[Cint_to_sizet(scope.timer)];
+			total.calls += 1;
+			total.cpu_ms += std::chrono::duration<float, std::milli>(scope.end - scope.start).count();
+			if (scope.gpu)
+			{
+				total.gpu = true;
+				total.gpu_ms += static_cast<float>(scope.gpu_end_ns - scope.gpu_start_ns) / 1e6f;
+			}
+		}
+
+		for (std::size_t index = 0; index < totals.size(); index += 1)
+		{
+			const auto& total = totals[index];
+			if (total.calls == 0)
+			{
+				continue;
+			}
+
+			auto& timer = profiler->timers[index];
+			timer.calls.add(static_cast<float>(total.calls));
+			timer.cpu_ms.add(total.cpu_ms);
+			if (total.gpu)
+			{
+				timer.gpu_ms.add(total.gpu_ms);
+			}
+		}
+	}
+}  //  namespace
+
+void RollingAverage::add(float sample)
+{
+	if (samples.size() < max_samples)
+	{
+		samples.emplace_back(sample);
+	}
+	else
+	{
+		samples[Cint_to_sizet(next)] = sample;
+	}
+	next = (next + 1) % max_samples;
+}
+
+float RollingAverage::get() const
+{
+	if (samples.empty())
+	{
+		return 0.0f;
+	}
+
+	float sum = 0.0f;
+	for (const auto sample: samples)
+	{
+		sum += sample;
+	}
+	return sum / static_cast<float>(samples.size());
+}
+
+Profiler::Profiler(Backend* b)
+	: backend(b)
+{
+}
+
+int Profiler::begin(std::string_view name, bool gpu)
+{
+	if (enabled == false)
+	{
+		return -1;
+	}
+
+	auto scope = ProfiledScope{};
+	scope.timer = find_or_add_timer(this, name);
+	scope.start = std::chrono::steady_clock::now();
+	if (gpu)
+	{
+		scope.gpu_start_query = backend->add_gpu_timestamp();
+		scope.gpu = scope.gpu_start_query.has_value();
+	}
+
+	current_frame.emplace_back(scope);
+	return Csizet_to_int(current_frame.size() - 1);
+}
+
+void Profiler::end(int index)
+{
+	if (index < 0)
+	{
+		return;
+	}
+
+	ASSERT(Cint_to_sizet(index) < current_frame.size());
+	auto& scope = current_frame[Cint_to_sizet(index)];
+	if (scope.ended)
+	{
+		return;
+	}
+
+	scope.end = std::chrono::steady_clock::now();
+	if (scope.gpu)
+	{
+		scope.gpu_end_query = backend->add_gpu_timestamp();
+		scope.gpu = scope.gpu_end_query.has_value();
+	}
+	scope.ended = true;
+}
+
+void Profiler::start_new_frame()
+{
+	for (std::size_t index = 0; index < current_frame.size(); index += 1)
+	{
+		end(Csizet_to_int(index));
+	}
+
+	if (current_frame.empty() == false)
+	{
+		pending_frames.emplace_back(PendingFrame{std::move(current_frame)});
+		current_frame.clear();
+	}
+
+	// the frames finish in order so stop at the first one the gpu is still working on
+	std::size_t done = 0;
+	while (done < pending_frames.size() && read_timestamps(backend, &pending_frames[done]))
+	{
+		add_frame(this, pending_frames[done]);
+		done += 1;
+	}
+	pending_frames.erase(
+		pending_frames.begin(), pending_frames.begin() + static_cast<std::ptrdiff_t>(done)
+	);
+}
+
+ScopedTimer::ScopedTimer(Profiler* p, std::string_view name, bool gpu)
+	: profiler(p)
+	, scope(profiler->begin(name, gpu))
+{
+}
+
+ScopedTimer::~ScopedTimer()
+{
+	profiler->end(scope);
+}
+
+std::string to_string(const Profiler& profiler)
+{
+	std::string r;
+	for (const auto& timer: profiler.timers)
+	{
+		r += fmt::format(
+			"{}: {:.1f} calls, cpu {:.3f} ms", timer.name, timer.calls.get(), timer.cpu_ms.get()
+		);
+		if (timer.gpu_ms.samples.empty() == false)
+		{
+			r += fmt::format(", gpu {:.3f} ms", timer.gpu_ms.get());
+		}
+		r += "\n";
+	}
+	return r;
+}
+
+}  //  namespace render
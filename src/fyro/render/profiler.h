@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+
+#include "fyro/types.h"
+
+namespace render
+{
+
+struct Backend;
+
+/** Average of the last few samples */
+struct RollingAverage
+{
+	static constexpr int max_samples = 60;
+
+	std::vector<float> samples;
+	int next = 0;
+
+	void add(float sample);
+	float get() const;
+};
+
+/** The rolling averages of all scopes with the same name, the times are per frame */
+struct TimerStats
+{
+	std::string name;
+	RollingAverage calls;
+	RollingAverage cpu_ms;
+	RollingAverage gpu_ms;	// empty if the backend doesn't support gpu timers
+};
+
+/** A started scope in the current frame */
+struct ProfiledScope
+{
+	int timer;	// index into Profiler::timers
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point end;
+	bool ended = false;
+
+	// the queries are cleared when the timestamps are read
+	std::optional<u32> gpu_start_query;
+	std::optional<u32> gpu_end_query;
+	u64 gpu_start_ns = 0;
+	u64 gpu_end_ns = 0;
+	bool gpu = false;
+};
+
+/** The scopes of a frame that are waiting for the gpu timestamps */
+struct PendingFrame
+{
+	std::vector<ProfiledScope> scopes;
+};
+
+/** Collects cpu and gpu time for named scopes and averages them over the last frames.
+ * The gpu timestamps are read a few frames later so the profiler never waits for the gpu.
+ */
+struct Profiler
+{
+	explicit Profiler(Backend* backend);
+
+	Backend* backend;
+	bool enabled = true;
+
+	std::vector<TimerStats> timers;	 // in the order they were first seen
+	std::vector<ProfiledScope> current_frame;
+	std::vector<PendingFrame> pending_frames;
+
+	/// start timing a scope, gpu also measures the time the gpu spent, returns the scope or -1
+	int begin(std::string_view name, bool gpu);
+
+	/// end a scope returned by begin, scopes doesn't need to end in the reverse order
+	void end(int scope);
+
+	/// finish the current frame and add all the frames that the gpu is done with to the averages
+	void start_new_frame();
+};
+
+/** Times the lifetime of the object */
+struct ScopedTimer
+{
+	ScopedTimer(Profiler* profiler, std::string_view name, bool gpu = false);
+	~ScopedTimer();
+
+	ScopedTimer(const ScopedTimer&) = delete;
+	void operator=(const ScopedTimer&) = delete;
+	ScopedTimer(ScopedTimer&&) = delete;
+	void operator=(ScopedTimer&&) = delete;
+
+	Profiler* profiler;
+	int scope;
+};
+
+/// one line per timer with the averages, meant to be dumped to a file
+std::string to_string(const Profiler& profiler);
+
+}  //  namespace render
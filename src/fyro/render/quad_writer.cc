@@ -0,0 +1,347 @@
+#include "fyro/render/quad_writer.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FYRO_QUAD_WRITER_SSE 1
+#include <emmintrin.h>
+#else
+#define FYRO_QUAD_WRITER_SSE 0
+#endif
+
+namespace render
+{
+
+namespace
+{
+	template<typename T>
+	u8* write(u8* cursor, const T& value)
+	{
+		std::memcpy(cursor, &value, sizeof(T));
+		return cursor + sizeof(T);
+	}
+
+	u8* write_slot(u8* cursor, const QuadWriter& writer, TextureSlot slot)
+	{
+		if (writer.multi_texture)
+		{
+			return write(cursor, slot);
+		}
+		return cursor;
+	}
+
+	u8 pack_unorm8(float f)
+	{
+		return static_cast<u8>(std::clamp(f, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	u16 pack_unorm16(float f)
+	{
+		return static_cast<u16>(std::clamp(f, 0.0f, 1.0f) * 65535.0f + 0.5f);
+	}
+
+	/** The tint of a quad, packed once and shared by all the corners */
+	struct PackedColor
+	{
+		u8 rgba[4];
+	};
+
+	PackedColor pack_color(const glm::vec4& c)
+	{
+		return {{pack_unorm8(c.x), pack_unorm8(c.y), pack_unorm8(c.z), pack_unorm8(c.w)}};
+	}
+
+	u8* write_full_vertex(
+		u8* cursor,
+		const QuadWriter& writer,
+		TextureSlot slot,
+		float x,
+		float y,
+		float z,
+		const glm::vec4& c,
+		float u,
+		float v
+	)
+	{
+		cursor = write(cursor, FullVertex{{x, y, z}, {c.x, c.y, c.z, c.w}, {u, v}});
+		return write_slot(cursor, writer, slot);
+	}
+
+	u8* write_packed_vertex(
+		u8* cursor,
+		const QuadWriter& writer,
+		TextureSlot slot,
+		float x,
+		float y,
+		const PackedColor& c,
+		u16 u,
+		u16 v
+	)
+	{
+		cursor = write(
+			cursor, PackedVertex{{x, y}, {c.rgba[0], c.rgba[1], c.rgba[2], c.rgba[3]}, {u, v}}
+		);
+		return write_slot(cursor, writer, slot);
+	}
+
+	template<typename V>
+	float get_z(const V& v)
+	{
+		if constexpr (std::is_same_v<V, Vertex3>)
+		{
+			return v.position.z;
+		}
+		else
+		{
+			return 0.0f;
+		}
+	}
+
+	template<typename V>
+	u8* write_vertex(u8* cursor, const QuadWriter& writer, TextureSlot slot, const V& v)
+	{
+		switch (writer.format)
+		{
+		case VertexFormat::full:
+			return write_full_vertex(
+				cursor,
+				writer,
+				slot,
+				v.position.x,
+				v.position.y,
+				get_z(v),
+				v.color,
+				v.texturecoord.x,
+				v.texturecoord.y
+			);
+		case VertexFormat::packed:
+			return write_packed_vertex(
+				cursor,
+				writer,
+				slot,
+				v.position.x,
+				v.position.y,
+				pack_color(v.color),
+				pack_unorm16(v.texturecoord.x),
+				pack_unorm16(v.texturecoord.y)
+			);
+		default: DIE("invalid vertex format"); return cursor;
+		}
+	}
+
+	template<typename V>
+	u8* write_vertices(
+		u8* cursor,
+		const QuadWriter& writer,
+		TextureSlot slot,
+		const V& v0,
+		const V& v1,
+		const V& v2,
+		const V& v3
+	)
+	{
+		cursor = write_vertex(cursor, writer, slot, v0);
+		cursor = write_vertex(cursor, writer, slot, v1);
+		cursor = write_vertex(cursor, writer, slot, v2);
+		return write_vertex(cursor, writer, slot, v3);
+	}
+
+#if FYRO_QUAD_WRITER_SSE
+	// the 4 full vertices are 36 floats, build them as 9 sse registers from the rect, tint and uv
+	// without going through the individual corners
+	u8* write_full_rect_sse(u8* cursor, const Rectf& scr, const Rectf& uv, const glm::vec4& tint)
+	{
+		const auto p = _mm_setr_ps(scr.left, scr.bottom, scr.right, scr.top);
+		const auto c = _mm_setr_ps(tint.x, tint.y, tint.z, tint.w);
+		const auto t = _mm_setr_ps(uv.left, uv.bottom, uv.right, uv.top);
+		const auto z = _mm_setzero_ps();
+
+		// _MM_SHUFFLE(d, c, b, a) picks (x[a], x[b], y[c], y[d])
+		const auto z_r = _mm_unpacklo_ps(z, c);  // 0 r 0 g
+		const auto a_ul = _mm_shuffle_ps(c, t, _MM_SHUFFLE(0, 0, 3, 3));  // a a ul ul
+		const auto vb_r = _mm_shuffle_ps(t, p, _MM_SHUFFLE(2, 2, 1, 1));  // vb vb r r
+		const auto b_z = _mm_shuffle_ps(p, z, _MM_SHUFFLE(0, 0, 1, 1));	 // b b 0 0
+		const auto a_ur = _mm_shuffle_ps(c, t, _MM_SHUFFLE(2, 2, 3, 3));  // a a ur ur
+		const auto vt_l = _mm_shuffle_ps(t, p, _MM_SHUFFLE(0, 0, 3, 3));  // vt vt l l
+		const auto t_z = _mm_shuffle_ps(p, z, _MM_SHUFFLE(0, 0, 3, 3));	 // t t 0 0
+
+		auto* f = reinterpret_cast<float*>(cursor);
+		_mm_storeu_ps(f + 0, _mm_shuffle_ps(p, z_r, _MM_SHUFFLE(1, 0, 1, 0)));	// l b 0 r
+		_mm_storeu_ps(f + 4, _mm_shuffle_ps(c, a_ul, _MM_SHUFFLE(2, 0, 2, 1)));	 // g b a ul
+		_mm_storeu_ps(f + 8, _mm_shuffle_ps(vb_r, b_z, _MM_SHUFFLE(2, 0, 2, 0)));	 // vb r b 0
+		_mm_storeu_ps(f + 12, c);  // r g b a
+		_mm_storeu_ps(f + 16, _mm_shuffle_ps(t, p, _MM_SHUFFLE(3, 2, 1, 2)));  // ur vb r t
+		_mm_storeu_ps(f + 20, _mm_shuffle_ps(z_r, c, _MM_SHUFFLE(2, 1, 1, 0)));  // 0 r g b
+		_mm_storeu_ps(f + 24, _mm_shuffle_ps(a_ur, vt_l, _MM_SHUFFLE(2, 0, 2, 0)));  // a ur vt l
+		_mm_storeu_ps(f + 28, _mm_shuffle_ps(t_z, c, _MM_SHUFFLE(1, 0, 2, 0)));	// t 0 r g
+		_mm_storeu_ps(f + 32, _mm_shuffle_ps(c, t, _MM_SHUFFLE(3, 0, 3, 2)));  // b a ul vt
+
+		return cursor + 4 * sizeof(FullVertex);
+	}
+#endif
+
+	u8* write_full_rect(
+		u8* cursor,
+		const QuadWriter& writer,
+		TextureSlot slot,
+		const Rectf& scr,
+		const Rectf& uv,
+		const glm::vec4& tint
+	)
+	{
+#if FYRO_QUAD_WRITER_SSE
+		if (writer.multi_texture == false)
+		{
+			return write_full_rect_sse(cursor, scr, uv, tint);
+		}
+#endif
+		cursor = write_full_vertex(
+			cursor, writer, slot, scr.left, scr.bottom, 0.0f, tint, uv.left, uv.bottom
+		);
+		cursor = write_full_vertex(
+			cursor, writer, slot, scr.right, scr.bottom, 0.0f, tint, uv.right, uv.bottom
+		);
+		cursor = write_full_vertex(
+			cursor, writer, slot, scr.right, scr.top, 0.0f, tint, uv.right, uv.top
+		);
+		return write_full_vertex(
+			cursor, writer, slot, scr.left, scr.top, 0.0f, tint, uv.left, uv.top
+		);
+	}
+
+	u8* write_packed_rect(
+		u8* cursor,
+		const QuadWriter& writer,
+		TextureSlot slot,
+		const Rectf& scr,
+		const Rectf& uv,
+		const glm::vec4& tint
+	)
+	{
+		// pack the shared values once instead of once per corner
+		const auto color = pack_color(tint);
+		const auto left = pack_unorm16(uv.left);
+		const auto bottom = pack_unorm16(uv.bottom);
+		const auto right = pack_unorm16(uv.right);
+		const auto top = pack_unorm16(uv.top);
+
+		const auto corner = [&](u8* at, float x, float y, u16 u, u16 v) -> u8*
+		{
+			return write_packed_vertex(at, writer, slot, x, y, color, u, v);
+		};
+		cursor = corner(cursor, scr.left, scr.bottom, left, bottom);
+		cursor = corner(cursor, scr.right, scr.bottom, right, bottom);
+		cursor = corner(cursor, scr.right, scr.top, right, top);
+		return corner(cursor, scr.left, scr.top, left, top);
+	}
+}  //  namespace
+
+std::size_t get_vertex_size(VertexFormat format, bool multi_texture)
+{
+	const auto slot_size = multi_texture ? sizeof(TextureSlot) : 0;
+	switch (format)
+	{
+	case VertexFormat::full: return sizeof(FullVertex) + slot_size;
+	case VertexFormat::packed: return sizeof(PackedVertex) + slot_size;
+	default: DIE("invalid vertex format"); return 0;
+	}
+}
+
+std::size_t get_sprite_size(VertexFormat format, bool multi_texture)
+{
+	const auto slot_size = multi_texture ? sizeof(TextureSlot) : 0;
+	switch (format)
+	{
+	case VertexFormat::full: return sizeof(FullSprite) + slot_size;
+	case VertexFormat::packed: return sizeof(PackedSprite) + slot_size;
+	default: DIE("invalid vertex format"); return 0;
+	}
+}
+
+u8* write_quad(
+	u8* cursor,
+	const QuadWriter& writer,
+	TextureSlot slot,
+	const Vertex2& v0,
+	const Vertex2& v1,
+	const Vertex2& v2,
+	const Vertex2& v3
+)
+{
+	return write_vertices(cursor, writer, slot, v0, v1, v2, v3);
+}
+
+u8* write_quad(
+	u8* cursor,
+	const QuadWriter& writer,
+	TextureSlot slot,
+	const Vertex3& v0,
+	const Vertex3& v1,
+	const Vertex3& v2,
+	const Vertex3& v3
+)
+{
+	return write_vertices(cursor, writer, slot, v0, v1, v2, v3);
+}
+
+u8* write_rect(
+	u8* cursor,
+	const QuadWriter& writer,
+	TextureSlot slot,
+	const Rectf& scr,
+	const Rectf& uv,
+	const glm::vec4& tint
+)
+{
+	switch (writer.format)
+	{
+	case VertexFormat::full: return write_full_rect(cursor, writer, slot, scr, uv, tint);
+	case VertexFormat::packed: return write_packed_rect(cursor, writer, slot, scr, uv, tint);
+	default: DIE("invalid vertex format"); return cursor;
+	}
+}
+
+u8* write_sprite(
+	u8* cursor,
+	const QuadWriter& writer,
+	TextureSlot slot,
+	const Rectf& scr,
+	const Rectf& uv,
+	const glm::vec4& tint
+)
+{
+	switch (writer.format)
+	{
+	case VertexFormat::full:
+		cursor = write(
+			cursor,
+			FullSprite{
+				{scr.left, scr.bottom, scr.right, scr.top},
+				{tint.x, tint.y, tint.z, tint.w},
+				{uv.left, uv.bottom, uv.right, uv.top}
+			}
+		);
+		break;
+	case VertexFormat::packed:
+	{
+		const auto color = pack_color(tint);
+		cursor = write(
+			cursor,
+			PackedSprite{
+				{scr.left, scr.bottom, scr.right, scr.top},
+				{color.rgba[0], color.rgba[1], color.rgba[2], color.rgba[3]},
+				{pack_unorm16(uv.left),
+				 pack_unorm16(uv.bottom),
+				 pack_unorm16(uv.right),
+				 pack_unorm16(uv.top)}
+			}
+		);
+		break;
+	}
+	default: DIE("invalid vertex format"); break;
+	}
+
+	return write_slot(cursor, writer, slot);
+}
+
+}  //  namespace render
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "fyro/render/render2.h"
+#include "fyro/rect.h"
+#include "fyro/types.h"
+
+namespace render
+{
+
+/** The vertex layouts the SpriteBatch uploads, see VertexFormat */
+struct FullVertex
+{
+	float position[3];
+	float color[4];
+	float texturecoord[2];
+};
+static_assert(sizeof(FullVertex) == 36);
+
+struct PackedVertex
+{
+	float position[2];
+	u8 color[4];
+	u16 texturecoord[2];
+};
+static_assert(sizeof(PackedVertex) == 16);
+
+/** A single instanced sprite, the vertex shader expands it to a quad */
+struct FullSprite
+{
+	float rect[4];
+	float color[4];
+	float texturerect[4];
+};
+static_assert(sizeof(FullSprite) == 48);
+
+struct PackedSprite
+{
+	float rect[4];
+	u8 color[4];
+	u16 texturerect[4];
+};
+static_assert(sizeof(PackedSprite) == 28);
+
+// a multi texture batch appends the texture slot to each vertex (or sprite)
+using TextureSlot = u32;
+
+std::size_t get_vertex_size(VertexFormat format, bool multi_texture);
+std::size_t get_sprite_size(VertexFormat format, bool multi_texture);
+
+/** How the vertices are written to the staging buffer */
+struct QuadWriter
+{
+	VertexFormat format;
+	bool multi_texture;
+};
+
+// all the write functions write through a raw cursor and return the cursor after the written data
+// the caller needs to make sure there is room for it
+
+/// write the four vertices of a quad
+u8* write_quad(
+	u8* cursor,
+	const QuadWriter& writer,
+	TextureSlot slot,
+	const Vertex2& v0,
+	const Vertex2& v1,
+	const Vertex2& v2,
+	const Vertex2& v3
+);
+u8* write_quad(
+	u8* cursor,
+	const QuadWriter& writer,
+	TextureSlot slot,
+	const Vertex3& v0,
+	const Vertex3& v1,
+	const Vertex3& v2,
+	const Vertex3& v3
+);
+
+/// expand a screen rect, uv rect and tint to the four vertices of a quad in one pass
+/// the corners are written counter clockwise from the left bottom, like quadf
+u8* write_rect(
+	u8* cursor,
+	const QuadWriter& writer,
+	TextureSlot slot,
+	const Rectf& scr,
+	const Rectf& uv,
+	const glm::vec4& tint
+);
+
+/// write a single instanced sprite
+u8* write_sprite(
+	u8* cursor,
+	const QuadWriter& writer,
+	TextureSlot slot,
+	const Rectf& scr,
+	const Rectf& uv,
+	const glm::vec4& tint
+);
+
+}  //  namespace render
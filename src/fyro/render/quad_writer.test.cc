@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include <array>
+#include <cstring>
+
+#include "fyro/render/quad_writer.h"
+
+using namespace render;
+
+namespace
+{
+	constexpr int benchmark_quads = 10000;
+
+	std::array<Vertex2, 4> get_corners(const Rectf& scr, const Rectf& uv, const glm::vec4& tint)
+	{
+		return {{
+			{{scr.left, scr.bottom}, tint, {uv.left, uv.bottom}},
+			{{scr.right, scr.bottom}, tint, {uv.right, uv.bottom}},
+			{{scr.right, scr.top}, tint, {uv.right, uv.top}},
+			{{scr.left, scr.top}, tint, {uv.left, uv.top}}
+		}};
+	}
+
+	Rectf get_rect(int index)
+	{
+		const auto x = static_cast<float>(index % 100);
+		const auto y = static_cast<float>(index / 100);
+		return {x, y, x + 16.0f, y + 16.0f};
+	}
+
+	// the old way: convert to Vertex3 and grow a vector one vertex at a time
+	void append_vertex_like_before(std::vector<u8>* data, const Vertex2& v2)
+	{
+		const auto v = Vertex3{{v2.position.x, v2.position.y, 0.0f}, v2.color, v2.texturecoord};
+		const auto vertex = FullVertex{
+			{v.position.x, v.position.y, v.position.z},
+			{v.color.x, v.color.y, v.color.z, v.color.w},
+			{v.texturecoord.x, v.texturecoord.y}
+		};
+		const auto offset = data->size();
+		data->resize(offset + sizeof(FullVertex));
+		std::memcpy(data->data() + offset, &vertex, sizeof(FullVertex));
+	}
+}  //  namespace
+
+TEST_CASE("quad_writer: rect kernel matches the generic quad", "[quad_writer]")
+{
+	const auto scr = Rectf{1.0f, 2.0f, 30.0f, 40.0f};
+	const auto uv = Rectf{0.25f, 0.5f, 0.75f, 1.0f};
+	const auto tint = glm::vec4{0.1f, 0.2f, 0.3f, 0.4f};
+	const auto c = get_corners(scr, uv, tint);
+
+	for (const auto format: {VertexFormat::full, VertexFormat::packed})
+	{
+		for (const auto multi_texture: {false, true})
+		{
+			const auto writer = QuadWriter{format, multi_texture};
+			const auto size = get_vertex_size(format, multi_texture) * 4;
+
+			std::vector<u8> rect(size + 8, 0);
+			std::vector<u8> quad(size + 8, 0);
+
+			auto* rect_end = write_rect(rect.data(), writer, 7, scr, uv, tint);
+			auto* quad_end = write_quad(quad.data(), writer, 7, c[0], c[1], c[2], c[3]);
+
+			CHECK(rect_end == rect.data() + size);
+			CHECK(quad_end == quad.data() + size);
+			CHECK(rect == quad);
+		}
+	}
+}
+
+TEST_CASE("quad_writer: benchmark", "[quad_writer][!benchmark]")
+{
+	const auto uv = Rectf{0.0f, 0.0f, 1.0f, 1.0f};
+	const auto tint = glm::vec4{1.0f};
+
+	BENCHMARK("before: 10000 quads, vertex by vertex into a growing vector")
+	{
+		std::vector<u8> data;
+		for (int index = 0; index < benchmark_quads; index += 1)
+		{
+			for (const auto& v: get_corners(get_rect(index), uv, tint))
+			{
+				append_vertex_like_before(&data, v);
+			}
+		}
+		return data.size();
+	};
+
+	std::vector<u8> staging(get_vertex_size(VertexFormat::full, false) * 4 * benchmark_quads);
+
+	BENCHMARK("after: 10000 quads, rect kernel into a presized buffer")
+	{
+		const auto writer = QuadWriter{VertexFormat::full, false};
+		auto* cursor = staging.data();
+		for (int index = 0; index < benchmark_quads; index += 1)
+		{
+			cursor = write_rect(cursor, writer, 0, get_rect(index), uv, tint);
+		}
+		return cursor - staging.data();
+	};
+
+	std::vector<u8> packed_staging(
+		get_vertex_size(VertexFormat::packed, false) * 4 * benchmark_quads
+	);
+
+	BENCHMARK("after: 10000 packed quads, rect kernel into a presized buffer")
+	{
+		const auto writer = QuadWriter{VertexFormat::packed, false};
+		auto* cursor = packed_staging.data();
+		for (int index = 0; index < benchmark_quads; index += 1)
+		{
+			cursor = write_rect(cursor, writer, 0, get_rect(index), uv, tint);
+		}
+		return cursor - packed_staging.data();
+	};
+}
@@ -1,8 +1,9 @@
 #include "fyro/render/render2.h"
 
-#include "fyro/dependencies/dependency_opengl.h"
-
-#include "fyro/render/shader.h"
+#include "fyro/cint.h"
+#include "fyro/render/backend.h"
+#include "fyro/render/quad_writer.h"
+#include "fyro/render/sprite_queue.h"
 #include "fyro/render/texture.h"
 
 
@@ -11,95 +12,120 @@ using namespace std::literals;
 namespace render
 {
 
-SpriteBatch::SpriteBatch(ShaderProgram* quad_shader, Render2* r)
-	: render(r)
-	, white_texture(load_image_from_color(
-		  0xffffffff, TextureEdge::clamp, TextureRenderStyle::pixel, Transparency::include
-	  ))
+namespace
 {
-	quad_shader->use();
-
-	glGenVertexArrays(1, &va);
-	glBindVertexArray(va);
-
-	constexpr auto vertex_size = 9 * sizeof(float);
-	constexpr auto max_vertices = 4 * max_quads;
-	constexpr auto max_indices = 6 * max_quads;
-
-	glGenBuffers(1, &vb);
-	glBindBuffer(GL_ARRAY_BUFFER, vb);
-	glBufferData(GL_ARRAY_BUFFER, vertex_size * max_vertices, nullptr, GL_DYNAMIC_DRAW);
-
-	auto relative_offset = [](unsigned int i)
+	QuadWriter get_writer(const SpriteBatch& batch)
 	{
-		return reinterpret_cast<void*>(i * sizeof(float));
-	};
+		return {batch.format, batch.multi_texture};
+	}
 
-	unsigned int offset = 0;
+	// size the staging buffer for the capacity, a quad is never smaller than a sprite
+	void resize_staging(SpriteBatch* batch)
+	{
+		const auto quad_size = get_vertex_size(batch->format, batch->multi_texture) * 4;
+		const auto used = batch->cursor - batch->data.data();
+		batch->data.resize(quad_size * Cint_to_sizet(batch->capacity));
+		batch->cursor = batch->data.data() + used;
+	}
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertex_size, relative_offset(offset));
-	offset += 3;
+	std::optional<int> find_texture_slot(const SpriteBatch& batch, Texture* texture)
+	{
+		// search backwards, the most recently added texture is the most likely to be reused
+		for (auto index = batch.textures.size(); index > 0; index -= 1)
+		{
+			if (batch.textures[index - 1] == texture)
+			{
+				return Csizet_to_int(index - 1);
+			}
+		}
 
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, vertex_size, relative_offset(offset));
-	offset += 4;
+		return std::nullopt;
+	}
 
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertex_size, relative_offset(offset));
-	offset += 2;
+	int get_texture_slot(SpriteBatch* batch, Texture* texture)
+	{
+		if (const auto found = find_texture_slot(*batch, texture); found)
+		{
+			return *found;
+		}
+
+		if (Csizet_to_int(batch->textures.size()) == batch->render->texture_slots)
+		{
+			batch->submit();
+		}
+
+		batch->textures.emplace_back(texture);
+		return Csizet_to_int(batch->textures.size()) - 1;
+	}
 
+	// make room for one more quad or sprite, grows the batch or submits it when it is full
+	void make_room_for_quad(SpriteBatch* batch)
+	{
+		if (batch->quads + batch->sprites < batch->capacity)
+		{
+			return;
+		}
+
+		if (batch->capacity < batch->max_quads)
+		{
+			// the data isn't uploaded until submit so just make room for more
+			batch->capacity = std::min(batch->capacity * 2, batch->max_quads);
+			resize_staging(batch);
+		}
+		else
+		{
+			batch->submit();
+		}
+	}
 
-	std::vector<u32> indices;
-	indices.reserve(max_indices);
+	// the staging data can't hold both, so draw the other kind first to keep the order
+	void start_quads(SpriteBatch* batch)
+	{
+		if (batch->sprites > 0)
+		{
+			batch->submit();
+		}
+		make_room_for_quad(batch);
+	}
 
-	for (auto quad_index = 0; quad_index < max_quads; quad_index += 1)
+	void start_sprites(SpriteBatch* batch)
 	{
-		const auto base = quad_index * 4;
-		indices.emplace_back(base + 0);
-		indices.emplace_back(base + 1);
-		indices.emplace_back(base + 2);
-
-		indices.emplace_back(base + 2);
-		indices.emplace_back(base + 3);
-		indices.emplace_back(base + 0);
+		if (batch->quads > 0)
+		{
+			batch->submit();
+		}
+		make_room_for_quad(batch);
 	}
 
-	ASSERT(max_indices == indices.size());
+	template<typename V>
+	void add_quad(
+		SpriteBatch* batch, Texture* texture, const V& v0, const V& v1, const V& v2, const V& v3
+	)
+	{
+		start_quads(batch);
 
-	glGenBuffers(1, &ib);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib);
-	glBufferData(
-		GL_ELEMENT_ARRAY_BUFFER, max_indices * sizeof(u32), indices.data(), GL_STATIC_DRAW
-	);
-}
+		const auto slot = static_cast<TextureSlot>(get_texture_slot(batch, texture));
+		batch->quads += 1;
+		batch->cursor = write_quad(batch->cursor, get_writer(*batch), slot, v0, v1, v2, v3);
+	}
+}  //  namespace
 
-SpriteBatch::~SpriteBatch()
+SpriteBatch::SpriteBatch(Render2* r, const BatchSettings& settings)
+	: render(r)
+	, white_texture(render->backend->create_white_texture())
+	, format(settings.format)
+	, multi_texture(settings.multi_texture)
+	, instanced(settings.instanced)
+	, max_quads(std::max(1, settings.max_quads))
+	, capacity(std::clamp(settings.quads, 1, max_quads))
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	glDeleteBuffers(1, &ib);
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glDeleteBuffers(1, &vb);
+	cursor = data.data();
+	resize_staging(this);
 
-	glBindVertexArray(0);
-	glDeleteVertexArrays(1, &va);
+	queue = std::make_unique<SpriteQueue>();
 }
 
-void add_vertex(SpriteBatch* batch, const Vertex3& v)
-{
-	batch->data.push_back(v.position.x);
-	batch->data.push_back(v.position.y);
-	batch->data.push_back(v.position.z);
-
-	batch->data.push_back(v.color.x);
-	batch->data.push_back(v.color.y);
-	batch->data.push_back(v.color.z);
-	batch->data.push_back(v.color.w);
-
-	batch->data.push_back(v.texturecoord.x);
-	batch->data.push_back(v.texturecoord.y);
-}
+SpriteBatch::~SpriteBatch() = default;
 
 Rectf get_sprite(const Texture& texture, const Recti& ri)
 {
@@ -117,11 +143,19 @@ void SpriteBatch::quad(
 	const Vertex2& v3
 )
 {
-	auto c = [](const Vertex2& v) -> Vertex3
+	Texture* texture = texture_argument.value_or(&white_texture);
+
+	if (sorting)
 	{
-		return Vertex3{{v.position.x, v.position.y, 0.0f}, v.color, v.texturecoord};
-	};
-	quad(texture_argument, c(v0), c(v1), c(v2), c(v3));
+		auto c = [](const Vertex2& v) -> Vertex3
+		{
+			return Vertex3{{v.position.x, v.position.y, 0.0f}, v.color, v.texturecoord};
+		};
+		queue->add(texture, c(v0), c(v1), c(v2), c(v3));
+		return;
+	}
+
+	add_quad(this, texture, v0, v1, v2, v3);
 }
 
 void SpriteBatch::quad(
@@ -134,31 +168,17 @@ void SpriteBatch::quad(
 {
 	Texture* texture = texture_argument.value_or(&white_texture);
 
-	if (quads == max_quads)
+	if (sorting)
 	{
-		submit();
-	}
-
-	if (current_texture == nullptr)
-	{
-		current_texture = texture;
-	}
-	else if (current_texture != texture)
-	{
-		submit();
-		current_texture = texture;
+		queue->add(texture, v0, v1, v2, v3);
+		return;
 	}
 
-	quads += 1;
-
-	add_vertex(this, v0);
-	add_vertex(this, v1);
-	add_vertex(this, v2);
-	add_vertex(this, v3);
+	add_quad(this, texture, v0, v1, v2, v3);
 }
 
 void SpriteBatch::quadf(
-	std::optional<Texture*> texture,
+	std::optional<Texture*> texture_argument,
 	const Rectf& scr,
 	const std::optional<Rectf>& texturecoord,
 	bool flip_x,
@@ -166,13 +186,41 @@ void SpriteBatch::quadf(
 )
 {
 	const auto tc = texturecoord.value_or(Rectf{1.0f, 1.0f});
-	quad(
-		texture,
-		{{scr.left, scr.bottom}, tint, {flip_x ? tc.right : tc.left, tc.bottom}},
-		{{scr.right, scr.bottom}, tint, {flip_x ? tc.left : tc.right, tc.bottom}},
-		{{scr.right, scr.top}, tint, {flip_x ? tc.left : tc.right, tc.top}},
-		{{scr.left, scr.top}, tint, {flip_x ? tc.right : tc.left, tc.top}}
-	);
+
+	if (sorting)
+	{
+		quad(
+			texture_argument,
+			{{scr.left, scr.bottom}, tint, {flip_x ? tc.right : tc.left, tc.bottom}},
+			{{scr.right, scr.bottom}, tint, {flip_x ? tc.left : tc.right, tc.bottom}},
+			{{scr.right, scr.top}, tint, {flip_x ? tc.left : tc.right, tc.top}},
+			{{scr.left, scr.top}, tint, {flip_x ? tc.right : tc.left, tc.top}}
+		);
+		return;
+	}
+
+	Texture* texture = texture_argument.value_or(&white_texture);
+
+	// flip by swapping the uvs, so the instance doesn't need a flag for it
+	const auto uv
+		= Rectf{flip_x ? tc.right : tc.left, tc.bottom, flip_x ? tc.left : tc.right, tc.top};
+
+	if (instanced)
+	{
+		start_sprites(this);
+
+		const auto slot = static_cast<TextureSlot>(get_texture_slot(this, texture));
+		sprites += 1;
+		cursor = write_sprite(cursor, get_writer(*this), slot, scr, uv, tint);
+	}
+	else
+	{
+		start_quads(this);
+
+		const auto slot = static_cast<TextureSlot>(get_texture_slot(this, texture));
+		quads += 1;
+		cursor = write_rect(cursor, get_writer(*this), slot, scr, uv, tint);
+	}
 }
 
 void SpriteBatch::quadi(
@@ -189,83 +237,62 @@ void SpriteBatch::quadi(
 
 void SpriteBatch::submit()
 {
-	if (quads == 0)
+	if (quads == 0 && sprites == 0)
 	{
 		return;
 	}
 
-	bind_texture(render->texture_uniform, *current_texture);
-	glBindVertexArray(va);
+	const auto timer = ScopedTimer{&render->profiler, "SpriteBatch::submit"};
+
+	const auto draw = BatchDraw{
+		sprites > 0 ? BatchContent::sprites : BatchContent::quads,
+		data.data(),
+		static_cast<std::size_t>(cursor - data.data()),
+		sprites > 0 ? sprites : quads,
+		capacity,
+		&textures
+	};
+	render->backend->draw(draw, &current_frame);
 
-	glBindBuffer(GL_ARRAY_BUFFER, vb);
-	glBufferSubData(
-		GL_ARRAY_BUFFER,
-		0,
-		static_cast<GLsizeiptr>(sizeof(float) * data.size()),
-		static_cast<const void*>(data.data())
-	);
-	glDrawElements(GL_TRIANGLES, 6 * quads, GL_UNSIGNED_INT, nullptr);
+	current_frame.flushes += 1;
 
-	data.resize(0);
+	cursor = data.data();
 	quads = 0;
-	current_texture = nullptr;
+	sprites = 0;
+	textures.clear();
 }
 
-Render2::Render2()
-	// todo(Gustav): move quad_description and quad_layout to a seperate setup
-	: quad_description(
-		  {{VertexType::position2, "position"},
-		   {VertexType::color4, "color"},
-		   {VertexType::texture2, "uv"}}
-	  )
-	, quad_layout(
-		  compile_shader_layout(compile_attribute_layouts({quad_description}), quad_description)
-	  )
-	, quad_shader(
-		  R"glsl(
-			#version 430 core
-			in vec3 position;
-			in vec4 color;
-			in vec2 uv;
-
-			uniform mat4 view_projection;
-			uniform mat4 transform;
-
-			out vec4 varying_color;
-			out vec2 varying_uv;
-
-			void main()
-			{
-				varying_color = color;
-				varying_uv = uv;
-				gl_Position = view_projection * transform * vec4(position, 1.0);
-			}
-		)glsl"sv,
-		  R"glsl(
-			#version 430 core
+void SpriteBatch::start_new_frame()
+{
+	last_frame = current_frame;
+	current_frame = {};
+}
 
-			in vec4 varying_color;
-			in vec2 varying_uv;
+Render2::Render2(std::unique_ptr<Backend> b, const BatchSettings& settings)
+	: backend(std::move(b))
+	, texture_slots(backend->get_texture_slots())
+	, profiler(backend.get())
+	, batch(this, settings)
+{
+}
 
-			uniform sampler2D uniform_texture;
+Render2::~Render2() = default;
 
-			out vec4 color;
+void Render2::start_new_frame()
+{
+	batch.start_new_frame();
+	profiler.start_new_frame();
+	layers = 0;
+}
 
-			void main()
-			{
-				color = texture(uniform_texture, varying_uv) * varying_color;
-			}
-		)glsl"sv,
-		  quad_layout
-	  )
-	, view_projection_uniform(quad_shader.get_uniform("view_projection"))
-	, transform_uniform(quad_shader.get_uniform("transform"))
-	, texture_uniform(quad_shader.get_uniform("uniform_texture"))
-	, batch(&quad_shader, this)
+void Render2::set_view_projection(const glm::mat4& view_projection)
 {
-	setup_textures(&quad_shader, {&texture_uniform});
+	backend->set_view_projection(view_projection);
+}
 
-	// todo(Gustav): verify mesh layout with SpriteBatch
+void Render2::set_transform(const glm::mat4& transform)
+{
+	backend->set_transform(transform);
 }
 
 }  //  namespace render
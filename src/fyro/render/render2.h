@@ -1,7 +1,8 @@
 #pragma once
 
-#include "fyro/render/shader.h"
+#include <memory>
 
+#include "fyro/render/profiler.h"
 #include "fyro/render/texture.h"
 #include "fyro/types.h"
 #include "fyro/rect.h"
@@ -10,8 +11,9 @@ namespace render
 {
 
 struct Texture;
-struct ShaderProgram;
 struct Render2;
+struct SpriteQueue;
+struct Backend;
 
 struct Vertex2
 {
@@ -27,20 +29,95 @@ struct Vertex3
 	glm::vec2 texturecoord;
 };
 
+/** How the SpriteBatch streams the vertex data to the gpu on submit */
+enum class VertexUpload
+{
+	/// glBufferSubData into a single buffer, may wait for the previous draw to finish
+	sub_data,
+
+	/// reallocate (orphan) the buffer before each upload and let the driver handle the rest
+	orphan,
+
+	/// unsynchronized writes into a ring of regions, each guarded by a fence
+	ring
+};
+
+/** Memory layout of the vertices the SpriteBatch uploads */
+enum class VertexFormat
+{
+	/// vec3 position, float rgba color and float uv: 36 bytes
+	full,
+
+	/// vec2 position, rgba8 normalized color and 16-bit normalized uv: 16 bytes
+	/// uvs are clamped to 0-1, so repeating textures need the full format
+	packed
+};
+
+/** Counters for a single frame of SpriteBatch usage */
+struct BatchStats
+{
+	/// number of times submit() sent data to the gpu
+	int flushes = 0;
+
+	/// number of times we had to wait for the gpu before we could write the vertex data
+	int stalls = 0;
+
+	/// number of draw calls issued
+	int draw_calls = 0;
+
+	/// number of quads drawn
+	int quads = 0;
+};
+
+/** Setup of the SpriteBatch, provided when creating Render2 */
+struct BatchSettings
+{
+	/// the number of quads the batch starts with
+	int quads = 100;
+
+	/// when full the batch grows (doubling) up to this many quads before it needs to flush
+	int max_quads = 10000;
+
+	VertexUpload upload = VertexUpload::ring;
+	VertexFormat format = VertexFormat::full;
+
+	/// bind several textures at once and store the texture slot in each vertex
+	/// so the batch only needs to flush when all the texture units are used
+	bool multi_texture = false;
+
+	/// quadf and quadi upload a single instance (rect, uv rect and tint) per sprite
+	/// and let the vertex shader expand the corners instead of uploading four vertices
+	bool instanced = false;
+};
+
+/** Collects quads on the cpu and hands them to the Backend when full or submitted */
 struct SpriteBatch
 {
-	static constexpr int max_quads = 100;
+	// upper limit of textures in a multi texture batch, regardless of hardware support
+	static constexpr int max_texture_slots = 32;
 
-	std::vector<float> data;
+	std::vector<u8> data;	// staging for either vertices or sprite instances, never both
+	u8* cursor = nullptr;  // where the next quad or sprite is written in data
 	int quads = 0;
-	Texture* current_texture = nullptr;
-	u32 va;
-	u32 vb;
-	u32 ib;
+	int sprites = 0;
+	std::vector<Texture*> textures;	 // one per texture slot, up to Render2::texture_slots
 	Render2* render;
 	Texture white_texture;
 
-	SpriteBatch(ShaderProgram* shader, Render2* r);
+	VertexFormat format;
+	bool multi_texture;
+	bool instanced;
+	int max_quads;
+	int capacity;  // current number of quads before we need to flush
+
+	BatchStats current_frame;
+	BatchStats last_frame;
+
+	// when sorting, quads are recorded in the queue and drawn when the layer is done
+	std::unique_ptr<SpriteQueue> queue;
+	bool sorting = false;
+
+	SpriteBatch(Render2* r, const BatchSettings& settings);
 	~SpriteBatch();
 
 	SpriteBatch(const SpriteBatch&) = delete;
@@ -78,20 +155,33 @@ struct SpriteBatch
 	);
 
 	void submit();
+
+	// moves the current stats to last_frame and starts counting from zero
+	void start_new_frame();
 };
 
 struct Render2
 {
-	Render2();
+	Render2(std::unique_ptr<Backend> backend, const BatchSettings& settings);
+	~Render2();
 
-	ShaderVertexAttributes quad_description;
-	CompiledShaderVertexAttributes quad_layout;
-	ShaderProgram quad_shader;
-	Uniform view_projection_uniform;
-	Uniform transform_uniform;
-	Uniform texture_uniform;
+	Render2(const Render2&) = delete;
+	void operator=(const Render2&) = delete;
+	Render2(Render2&&) = delete;
+	void operator=(Render2&&) = delete;
+
+	std::unique_ptr<Backend> backend;
+	int texture_slots;
+	Profiler profiler;
+	int layers = 0;	 // number of 2d layers started this frame
 
 	SpriteBatch batch;
+
+	// starts the frame for the batch stats, the profiler and the layer count
+	void start_new_frame();
+
+	void set_view_projection(const glm::mat4& view_projection);
+	void set_transform(const glm::mat4& transform);
 };
 
 }  //  namespace render
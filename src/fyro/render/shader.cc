@@ -283,7 +283,9 @@ void ShaderProgram::set_mat(const Uniform& uniform, const glm::mat3& mat) const
 void setup_textures(ShaderProgram* shader, std::vector<Uniform*> uniform_list)
 {
 	// OpenGL should support atleast 16 textures
-	ASSERT(uniform_list.size() <= 16);
+	int max_units = 16;
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_units);
+	ASSERT(Csizet_to_int(uniform_list.size()) <= max_units);
 
 	shader->use();
 
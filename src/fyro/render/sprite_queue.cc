@@ -0,0 +1,127 @@
+#include "fyro/render/sprite_queue.h"
+
+#include <cstring>
+
+#include "fyro/assert.h"
+
+namespace render
+{
+
+namespace
+{
+	u32 to_sortable_bits(float f)
+	{
+		u32 bits = 0;
+		std::memcpy(&bits, &f, sizeof(bits));
+
+		// flip the bits so the unsigned order matches the float order
+		if ((bits & 0x80000000u) != 0)
+		{
+			return ~bits;
+		}
+		else
+		{
+			return bits | 0x80000000u;
+		}
+	}
+}  //  namespace
+
+u64 create_sort_key(u8 layer, float depth, u8 shader, u16 texture)
+{
+	// 8 bit layer, 24 bit depth, 8 bit shader, 16 bit texture and 8 unused bits
+	// invert the depth so a higher depth is sorted (drawn) first
+	const auto depth_bits = static_cast<u64>((~to_sortable_bits(depth)) >> 8);
+	return (u64{layer} << 56) | (depth_bits << 32) | (u64{shader} << 24) | (u64{texture} << 8);
+}
+
+void radix_sort(std::vector<SortItem>* items, std::vector<SortItem>* scratch)
+{
+	if (items->empty())
+	{
+		return;
+	}
+
+	scratch->resize(items->size());
+
+	constexpr int bits_per_pass = 8;
+	constexpr std::size_t buckets = 1 << bits_per_pass;
+
+	for (int shift = 0; shift < 64; shift += bits_per_pass)
+	{
+		const auto digit = [shift](const SortItem& item) -> std::size_t
+		{
+			return static_cast<std::size_t>((item.key >> shift) & (buckets - 1));
+		};
+
+		std::array<std::size_t, buckets> offsets = {};
+		for (const auto& item: *items)
+		{
+			offsets[digit(item)] += 1;
+		}
+
+		// all items share this digit, so this pass wouldn't change the order
+		if (offsets[digit(items->front())] == items->size())
+		{
+			continue;
+		}
+
+		std::size_t offset = 0;
+		for (auto& o: offsets)
+		{
+			const auto count = o;
+			o = offset;
+			offset += count;
+		}
+
+		for (const auto& item: *items)
+		{
+			(*scratch)[offsets[digit(item)]++] = item;
+		}
+
+		std::swap(*items, *scratch);
+	}
+}
+
+void SpriteQueue::add(
+	Texture* texture, const Vertex3& v0, const Vertex3& v1, const Vertex3& v2, const Vertex3& v3
+)
+{
+	auto found = texture_ids.find(texture);
+	if (found == texture_ids.end())
+	{
+		ASSERT(texture_ids.size() < 0xffff);
+		found = texture_ids.emplace(texture, static_cast<u16>(texture_ids.size())).first;
+	}
+
+	// only the quad shader exists for now
+	const u8 shader = 0;
+
+	items.push_back(
+		{create_sort_key(layer, depth, shader, found->second), static_cast<u32>(quads.size())}
+	);
+	quads.push_back({texture, {v0, v1, v2, v3}});
+}
+
+void SpriteQueue::flush(SpriteBatch* batch)
+{
+	radix_sort(&items, &scratch);
+
+	for (const auto& item: items)
+	{
+		const auto& q = quads[item.index];
+		batch->quad(q.texture, q.vertices[0], q.vertices[1], q.vertices[2], q.vertices[3]);
+	}
+
+	clear();
+}
+
+void SpriteQueue::clear()
+{
+	quads.clear();
+	items.clear();
+	texture_ids.clear();
+	layer = 0;
+	depth = 0.0f;
+}
+
+}  //  namespace render
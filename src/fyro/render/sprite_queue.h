@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <unordered_map>
+
+#include "fyro/render/render2.h"
+#include "fyro/types.h"
+
+namespace render
+{
+
+/** A quad recorded by a sorting SpriteBatch */
+struct QueuedQuad
+{
+	Texture* texture;
+	std::array<Vertex3, 4> vertices;
+};
+
+/** A sort key and the index of the QueuedQuad it was created for */
+struct SortItem
+{
+	u64 key;
+	u32 index;
+};
+
+/** Creates a key that sorts by layer, then depth (higher is further back), shader and texture */
+u64 create_sort_key(u8 layer, float depth, u8 shader, u16 texture);
+
+/** Stable LSD radix sort on the key, scratch is used as temporary storage */
+void radix_sort(std::vector<SortItem>* items, std::vector<SortItem>* scratch);
+
+/** Records quads and draws them in sort key order instead of in call order.
+ * Quads with the same layer and depth are grouped by texture so the batch needs fewer flushes.
+ */
+struct SpriteQueue
+{
+	// state for the quads that are added
+	u8 layer = 0;
+	float depth = 0.0f;
+
+	std::vector<QueuedQuad> quads;
+	std::vector<SortItem> items;
+	std::vector<SortItem> scratch;
+	std::unordered_map<Texture*, u16> texture_ids;
+
+	void add(
+		Texture* texture, const Vertex3& v0, const Vertex3& v1, const Vertex3& v2, const Vertex3& v3
+	);
+
+	// sort the recorded quads, send them to the batch and clear the queue
+	void flush(SpriteBatch* batch);
+
+	void clear();
+};
+
+}  //  namespace render
@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include "fyro/render/sprite_queue.h"
+
+using namespace render;
+
+namespace
+{
+	std::vector<SortItem> get_random_items(std::size_t count, u64 key_mask, unsigned int seed)
+	{
+		auto generator = std::mt19937_64{seed};
+		std::vector<SortItem> items;
+		items.reserve(count);
+		for (std::size_t index = 0; index < count; index += 1)
+		{
+			items.emplace_back(SortItem{generator() & key_mask, static_cast<u32>(index)});
+		}
+		return items;
+	}
+
+	void require_same_as_stable_sort(std::vector<SortItem> items)
+	{
+		auto expected = items;
+		std::stable_sort(
+			expected.begin(),
+			expected.end(),
+			[](const SortItem& lhs, const SortItem& rhs) { return lhs.key < rhs.key; }
+		);
+
+		std::vector<SortItem> scratch;
+		radix_sort(&items, &scratch);
+
+		REQUIRE(items.size() == expected.size());
+		for (std::size_t index = 0; index < items.size(); index += 1)
+		{
+			REQUIRE(items[index].key == expected[index].key);
+			REQUIRE(items[index].index == expected[index].index);
+		}
+	}
+}  //  namespace
+
+TEST_CASE("sprite_queue: radix sort matches a stable sort", "[sprite_queue]")
+{
+	SECTION("empty")
+	{
+		require_same_as_stable_sort({});
+	}
+
+	SECTION("random keys")
+	{
+		require_same_as_stable_sort(get_random_items(1000, ~u64{0}, 1));
+	}
+
+	SECTION("few distinct keys keeps the insertion order")
+	{
+		require_same_as_stable_sort(get_random_items(1000, 0x3, 2));
+	}
+
+	SECTION("keys that only differ in some bytes skip passes")
+	{
+		require_same_as_stable_sort(get_random_items(1000, 0x00ff00000000ff00, 3));
+	}
+
+	SECTION("identical keys")
+	{
+		require_same_as_stable_sort(get_random_items(100, 0, 4));
+	}
+
+	SECTION("real sort keys")
+	{
+		auto generator = std::mt19937{5};
+		auto layer = std::uniform_int_distribution<int>{0, 3};
+		auto depth = std::uniform_real_distribution<float>{-100.0f, 100.0f};
+		auto texture = std::uniform_int_distribution<int>{0, 7};
+
+		std::vector<SortItem> items;
+		for (u32 index = 0; index < 1000; index += 1)
+		{
+			const auto key = create_sort_key(
+				static_cast<u8>(layer(generator)),
+				depth(generator),
+				0,
+				static_cast<u16>(texture(generator))
+			);
+			items.emplace_back(SortItem{key, index});
+		}
+		require_same_as_stable_sort(items);
+	}
+}
+
+TEST_CASE("sprite_queue: keys sort by layer, depth, shader and texture", "[sprite_queue]")
+{
+	SECTION("layer")
+	{
+		CHECK(create_sort_key(0, -10.0f, 255, 65535) < create_sort_key(1, 10.0f, 0, 0));
+	}
+
+	SECTION("a higher depth sorts first")
+	{
+		CHECK(create_sort_key(0, 10.0f, 0, 0) < create_sort_key(0, 1.0f, 0, 0));
+		CHECK(create_sort_key(0, 1.0f, 0, 0) < create_sort_key(0, 0.0f, 0, 0));
+		CHECK(create_sort_key(0, 0.0f, 0, 0) < create_sort_key(0, -1.0f, 0, 0));
+		CHECK(create_sort_key(0, -1.0f, 0, 0) < create_sort_key(0, -10.0f, 0, 0));
+	}
+
+	SECTION("depth")
+	{
+		CHECK(create_sort_key(0, 10.0f, 255, 65535) < create_sort_key(0, 1.0f, 0, 0));
+	}
+
+	SECTION("shader")
+	{
+		CHECK(create_sort_key(0, 1.0f, 0, 65535) < create_sort_key(0, 1.0f, 1, 0));
+	}
+
+	SECTION("texture")
+	{
+		CHECK(create_sort_key(0, 1.0f, 0, 0) < create_sort_key(0, 1.0f, 0, 1));
+		CHECK(create_sort_key(0, 1.0f, 0, 1) == create_sort_key(0, 1.0f, 0, 1));
+	}
+}
@@ -0,0 +1,94 @@
+#include "fyro/render/static_quads.h"
+
+#include "fyro/render/quad_writer.h"
+
+namespace render
+{
+
+namespace
+{
+	QuadWriter get_writer(const Render2& render)
+	{
+		return {render.batch.format, render.batch.multi_texture};
+	}
+
+	std::size_t get_quad_size(const QuadWriter& writer)
+	{
+		return get_vertex_size(writer.format, writer.multi_texture) * 4;
+	}
+}  //  namespace
+
+StaticAnimations::StaticAnimations(Render2* r, const std::vector<TileAnimation>& animations)
+	: render(r)
+	, id(render->backend->create_animations(animations))
+{
+}
+
+StaticAnimations::~StaticAnimations()
+{
+	render->backend->destroy_animations(id);
+}
+
+StaticQuads::StaticQuads(Render2* r)
+	: render(r)
+	, id(render->backend->create_static_quads())
+{
+}
+
+StaticQuads::~StaticQuads()
+{
+	render->backend->destroy_static_quads(id);
+}
+
+void StaticQuads::clear()
+{
+	data.clear();
+	animations.clear();
+	quads = 0;
+	changed = true;
+}
+
+void StaticQuads::add(
+	const Vertex2& v0,
+	const Vertex2& v1,
+	const Vertex2& v2,
+	const Vertex2& v3,
+	std::optional<u32> animation
+)
+{
+	const auto writer = get_writer(*render);
+
+	const auto offset = data.size();
+	data.resize(offset + get_quad_size(writer));
+	write_quad(data.data() + offset, writer, 0, v0, v1, v2, v3);
+
+	animations.insert(animations.end(), 4, animation ? *animation + 1 : 0);
+
+	quads += 1;
+	changed = true;
+}
+
+void StaticQuads::draw(
+	SpriteBatch* batch, const Texture& texture, const StaticAnimations* table, float time
+)
+{
+	if (quads == 0)
+	{
+		return;
+	}
+
+	batch->submit();
+
+	if (changed)
+	{
+		render->backend->upload_static_quads(
+			id, StaticUpload{data.data(), data.size(), quads, &animations}
+		);
+		changed = false;
+	}
+
+	const auto draw = StaticDraw{&texture, table != nullptr ? table->id : 0, time};
+	render->backend->draw_static_quads(id, draw, &batch->current_frame);
+}
+
+}  //  namespace render
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "fyro/render/backend.h"
+#include "fyro/render/render2.h"
+#include "fyro/types.h"
+
+namespace render
+{
+
+/** A table of uv animations on the gpu that StaticQuads can play */
+struct StaticAnimations
+{
+	StaticAnimations(Render2* render, const std::vector<TileAnimation>& animations);
+	~StaticAnimations();
+
+	StaticAnimations(const StaticAnimations&) = delete;
+	void operator=(const StaticAnimations&) = delete;
+	StaticAnimations(StaticAnimations&&) = delete;
+	void operator=(StaticAnimations&&) = delete;
+
+	Render2* render;
+	u32 id;
+};
+
+/** Quads that are uploaded to a gpu buffer of their own and then drawn with a single call.
+ * The quads are only uploaded again after they have changed, so use it for geometry that rarely
+ * changes like the tiles of a map.
+ */
+struct StaticQuads
+{
+	explicit StaticQuads(Render2* render);
+	~StaticQuads();
+
+	StaticQuads(const StaticQuads&) = delete;
+	void operator=(const StaticQuads&) = delete;
+	StaticQuads(StaticQuads&&) = delete;
+	void operator=(StaticQuads&&) = delete;
+
+	Render2* render;
+	u32 id;
+
+	std::vector<u8> data;  // the vertices, laid out like the batch quads
+	std::vector<u32> animations;  // one per vertex, 0 or the animation + 1
+	int quads = 0;
+	bool changed = false;  // if the data needs to be uploaded before the next draw
+
+	void clear();
+	/// the animation is an index in the StaticAnimations the quads are drawn with
+	void add(
+		const Vertex2& v0,
+		const Vertex2& v1,
+		const Vertex2& v2,
+		const Vertex2& v3,
+		std::optional<u32> animation = std::nullopt
+	);
+
+	/// submits the batch so the order is kept and draws all the quads with the texture
+	/// the animated quads show the frame at the time
+	void draw(
+		SpriteBatch* batch,
+		const Texture& texture,
+		const StaticAnimations* table = nullptr,
+		float time = 0.0f
+	);
+};
+
+}  //  namespace render
@@ -198,3 +198,35 @@ std::shared_ptr<render::Texture> load_texture(const std::string& path)
 		render::Transparency::include
 	));
 }
+
+render::Image load_image(const std::string& path)
+{
+	const auto bytes = read_file_to_bytes(path);
+
+	int width = 0;
+	int height = 0;
+	int junk_channels = 0;
+
+	stbi_set_flip_vertically_on_load(false);
+	auto* pixel_data = stbi_load_from_memory(
+		reinterpret_cast<const unsigned char*>(bytes.data()),
+		static_cast<int>(bytes.size()),
+		&width,
+		&height,
+		&junk_channels,
+		4
+	);
+
+	if (pixel_data == nullptr)
+	{
+		LOG_ERROR("ERROR: Failed to load image {0}", path);
+		return {};
+	}
+
+	auto r = render::Image{};
+	r.width = width;
+	r.height = height;
+	r.pixels.assign(pixel_data, pixel_data + Cint_to_sizet(width * height * 4));
+	stbi_image_free(pixel_data);
+	return r;
+}
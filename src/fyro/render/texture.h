@@ -71,7 +71,18 @@ Texture load_image_from_embedded(
 
 Texture load_image_from_color(u32 pixel, TextureEdge te, TextureRenderStyle trs, Transparency t);
 
+/** Decoded rgba pixels, the first row is the top of the image */
+struct Image
+{
+	int width = 0;
+	int height = 0;
+	std::vector<u8> pixels;
+};
+
 
 }  //  namespace render
 
 std::shared_ptr<render::Texture> load_texture(const std::string& path);
+
+/// decode a image without creating a texture, the image is empty if it failed to load
+render::Image load_image(const std::string& path);
@@ -15,7 +15,9 @@ std::optional<VertexType> parse_vertex_type(const std::string& name)
 	}
 
 	NAME(position2)
-	else NAME(position3) else NAME(normal3) else NAME(color4) else NAME(texture2) else return {};
+	else NAME(position3) else NAME(normal3) else NAME(color4) else NAME(texture2) else NAME(
+		texture_slot1
+	) else NAME(rect4) else NAME(texture_rect4) else NAME(animation1) else return {};
 #undef NAME
 }
 
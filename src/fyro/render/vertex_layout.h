@@ -13,7 +13,11 @@ enum class VertexType
 	position3,
 	normal3,
 	color4,
-	texture2
+	texture2,
+	texture_slot1,
+	rect4,
+	texture_rect4,
+	animation1
 	// change to include other textcoords and custom types that are created from scripts
 };
 
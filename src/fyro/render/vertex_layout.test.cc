@@ -19,6 +19,10 @@ struct fmt::formatter<VertexType> : formatter<string_view>
 		case VertexType::normal3: name = "normal3"; break;
 		case VertexType::color4: name = "color4"; break;
 		case VertexType::texture2: name = "texture2"; break;
+		case VertexType::texture_slot1: name = "texture_slot1"; break;
+		case VertexType::rect4: name = "rect4"; break;
+		case VertexType::texture_rect4: name = "texture_rect4"; break;
+		case VertexType::animation1: name = "animation1"; break;
 		}
 		return formatter<string_view>::format(name, ctx);
 	}
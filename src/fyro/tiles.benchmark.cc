@@ -0,0 +1,229 @@
+#include "fyro/tiles.benchmark.h"
+
+#include <chrono>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+#include <tmxlite/Map.hpp>
+
+#include "fyro/exception.h"
+#include "fyro/log.h"
+#include "fyro/rendertypes.h"
+#include "fyro/tiles.h"
+#include "fyro/render/backend.recording.h"
+#include "fyro/render/render2.h"
+
+using json = nlohmann::json;
+
+namespace
+{
+	constexpr int tile_size = 16;
+	constexpr int tileset_size = 256;
+
+	// the first tiles in the tileset have a special meaning, the rest are plain tiles
+	constexpr std::uint32_t solid_gid = 1;
+	constexpr std::uint32_t animated_gid = 2;
+	constexpr std::uint32_t first_plain_gid = 4;
+	constexpr std::uint32_t tile_count = (tileset_size / tile_size) * (tileset_size / tile_size);
+
+	// the same tile always gets the same value so the maps don't depend on a random seed
+	std::uint32_t hash_tile(int x, int y, int layer)
+	{
+		auto h = (static_cast<std::uint32_t>(x) * 73856093u)
+			   ^ (static_cast<std::uint32_t>(y) * 19349663u)
+			   ^ (static_cast<std::uint32_t>(layer) * 83492791u);
+		h ^= h >> 13;
+		h *= 0x5bd1e995u;
+		h ^= h >> 15;
+		return h;
+	}
+
+	float to_unit(std::uint32_t h)
+	{
+		return static_cast<float>(h % 10000u) / 10000.0f;
+	}
+
+	double get_ms_since(std::chrono::steady_clock::time_point start)
+	{
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		return std::chrono::duration<double, std::milli>(elapsed).count();
+	}
+
+	// the recording backend has no textures so only the size is needed
+	std::shared_ptr<render::Texture> load_fake_texture(const std::string&)
+	{
+		auto texture = std::make_shared<render::Texture>();
+		texture->width = tileset_size;
+		texture->height = tileset_size;
+		return texture;
+	}
+
+	constexpr int update_count = 1000;
+	constexpr int render_frames = 120;
+	const auto view_size = glm::vec2{1280.0f, 720.0f};
+
+	json run_benchmark(const SyntheticMap& settings)
+	{
+		tmx::Map source;
+		if (source.loadFromString(make_synthetic_tmx(settings), "") == false)
+		{
+			throw Exception{{"failed to parse the synthetic tmx map"}};
+		}
+
+		auto textures = TextureCache{load_fake_texture};
+		Map map;
+
+		const auto load_start = std::chrono::steady_clock::now();
+		map.load_from_map(source, &textures);
+		const auto load_ms = get_ms_since(load_start);
+
+		const auto update_start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < update_count; frame += 1)
+		{
+			map.update(1.0f / 60.0f);
+		}
+		const auto update_ms = get_ms_since(update_start) / update_count;
+
+		// pan the camera diagonally over the map, the first pass uploads the chunks
+		auto backend = std::make_unique<render::RecordingBackend>(1, false);
+		auto* commands = &backend->commands;
+		auto render = render::Render2{std::move(backend), {}};
+		const auto map_size
+			= glm::vec2{static_cast<float>(settings.width), static_cast<float>(settings.height)}
+			* static_cast<float>(tile_size);
+		const auto pan = glm::max(map_size - view_size, glm::vec2{0.0f, 0.0f});
+		const auto render_pass = [&]()
+		{
+			for (int frame = 0; frame < render_frames; frame += 1)
+			{
+				render.start_new_frame();
+				const auto t = static_cast<float>(frame) / static_cast<float>(render_frames - 1);
+				const auto at = pan * t;
+				map.render(render.batch, Rectf{view_size.x, view_size.y}.translate(at.x, at.y));
+				render.batch.submit();
+				commands->clear();
+			}
+		};
+		render_pass();
+		const auto render_start = std::chrono::steady_clock::now();
+		render_pass();
+		const auto render_ms = get_ms_since(render_start) / render_frames;
+
+		const auto tiles = static_cast<double>(settings.width) * settings.height * settings.layers;
+		const auto bytes_per_tile = static_cast<double>(map.get_memory_usage()) / tiles;
+
+		LOG_INFO(
+			"{0}x{1}: load {2:.1f} ms, update {3:.4f} ms, render {4:.3f} ms, {5:.1f} bytes/tile",
+			settings.width,
+			settings.height,
+			load_ms,
+			update_ms,
+			render_ms,
+			bytes_per_tile
+		);
+
+		return json{
+			{"width", settings.width},
+			{"height", settings.height},
+			{"tiles", tiles},
+			{"load_ms", load_ms},
+			{"update_ms", update_ms},
+			{"render_ms", render_ms},
+			{"bytes_per_tile", bytes_per_tile},
+			{"collisions", map.get_collisions().size()}
+		};
+	}
+}  //  namespace
+
+std::string make_synthetic_tmx(const SyntheticMap& settings)
+{
+	const auto size = fmt::format("width=\"{0}\" height=\"{1}\"", settings.width, settings.height);
+
+	std::string r = fmt::format(
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<map version=\"1.8\" orientation=\"orthogonal\" renderorder=\"right-down\" {0} "
+		"tilewidth=\"{1}\" tileheight=\"{1}\" infinite=\"0\">\n"
+		"<tileset firstgid=\"1\" name=\"tiles\" tilewidth=\"{1}\" tileheight=\"{1}\" "
+		"tilecount=\"{2}\" columns=\"{3}\">\n"
+		"<image source=\"tiles.png\" width=\"{4}\" height=\"{4}\"/>\n"
+		"<tile id=\"{5}\"><objectgroup><object id=\"1\" x=\"0\" y=\"0\" width=\"{1}\" "
+		"height=\"{1}\"/></objectgroup></tile>\n"
+		"<tile id=\"{6}\"><animation><frame tileid=\"{6}\" duration=\"100\"/>"
+		"<frame tileid=\"{7}\" duration=\"100\"/></animation></tile>\n"
+		"</tileset>\n",
+		size,
+		tile_size,
+		tile_count,
+		tileset_size / tile_size,
+		tileset_size,
+		solid_gid - 1,
+		animated_gid - 1,
+		animated_gid
+	);
+
+	for (int layer = 0; layer < settings.layers; layer += 1)
+	{
+		r += fmt::format(
+			"<layer id=\"{0}\" name=\"layer{0}\" {1}><data encoding=\"csv\">\n", layer + 1, size
+		);
+		for (int y = 0; y < settings.height; y += 1)
+		{
+			for (int x = 0; x < settings.width; x += 1)
+			{
+				const auto h = hash_tile(x, y, layer);
+				const auto v = to_unit(h);
+
+				const auto plain_count = tile_count - first_plain_gid + 1;
+				std::uint32_t gid = first_plain_gid + (h >> 16) % plain_count;
+				if (v < settings.collision_density)
+				{
+					gid = solid_gid;
+				}
+				else if (v < settings.collision_density + settings.animated_density)
+				{
+					gid = animated_gid;
+				}
+
+				// some tiles are flipped to include the flip handling
+				const auto flip = (h >> 8) % 11 == 0 ? 0x80000000u : 0u;
+				const auto is_last = x + 1 == settings.width && y + 1 == settings.height;
+				r += fmt::format("{0}{1}", gid | flip, is_last ? "" : ",");
+			}
+			r += "\n";
+		}
+		r += "</data></layer>\n";
+	}
+
+	r += "</map>\n";
+	return r;
+}
+
+void run_tiles_benchmark(const std::string& json_path, const SyntheticMap& settings)
+{
+	auto results = json::array();
+	for (int size = 64; size <= 2048; size *= 2)
+	{
+		auto map = settings;
+		map.width = size;
+		map.height = size;
+		results.emplace_back(run_benchmark(map));
+	}
+
+	const auto report = json{
+		{"layers", settings.layers},
+		{"animated_density", settings.animated_density},
+		{"collision_density", settings.collision_density},
+		{"maps", results}
+	};
+
+	auto file = std::ofstream{json_path};
+	file << report.dump(1, '\t') << "\n";
+	if (file)
+	{
+		LOG_INFO("Saved the tiles benchmark to {0}", json_path);
+	}
+	else
+	{
+		LOG_WARNING("Failed to save the tiles benchmark to {0}", json_path);
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+/** The shape of a generated tmx map */
+struct SyntheticMap
+{
+	int width = 64;
+	int height = 64;
+	int layers = 2;
+	float animated_density = 0.05f;	 // part of the tiles that are animated
+	float collision_density = 0.2f;	 // part of the tiles that have a collision
+};
+
+/// a orthogonal tmx map of 16x16 tiles from a single 256x256 tileset image, the same settings give
+/// the same map, the image is never read unless the map is loaded with real textures
+std::string make_synthetic_tmx(const SyntheticMap& settings);
+
+/// load, update and render synthetic maps from 64x64 to 2048x2048 tiles without a gpu and write
+/// the times and the memory per tile as json, the size of the settings is ignored
+void run_tiles_benchmark(const std::string& json_path, const SyntheticMap& settings);
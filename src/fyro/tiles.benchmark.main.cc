@@ -0,0 +1,146 @@
+#include "fyro/log.h"
+#include "fyro/exception.h"
+#include "fyro/tiles.benchmark.h"
+
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+	std::optional<int> parse_int(const std::string& value)
+	{
+		char* end = nullptr;
+		errno = 0;
+		const long parsed = std::strtol(value.c_str(), &end, 10);
+		if (value.empty() || *end != '\0' || errno == ERANGE || parsed < INT_MIN
+			|| parsed > INT_MAX)
+		{
+			return std::nullopt;
+		}
+		return static_cast<int>(parsed);
+	}
+
+	std::optional<float> parse_float(const std::string& value)
+	{
+		char* end = nullptr;
+		errno = 0;
+		const float parsed = std::strtof(value.c_str(), &end);
+		if (value.empty() || *end != '\0' || errno == ERANGE || std::isfinite(parsed) == false)
+		{
+			return std::nullopt;
+		}
+		return parsed;
+	}
+
+	std::optional<float> parse_density(const std::string& value)
+	{
+		const auto parsed = parse_float(value);
+		if (parsed && *parsed >= 0.0f && *parsed <= 1.0f)
+		{
+			return parsed;
+		}
+		return std::nullopt;
+	}
+
+	void print_usage()
+	{
+		LOG_INFO(
+			"usage: fyro_bench <results.json> [--layers count] [--animated density] "
+			"[--collisions density]"
+		);
+	}
+}  //  namespace
+
+int run(int argc, char** argv)
+{
+	std::optional<std::string> json_path;
+	auto synthetic_map = SyntheticMap{};
+
+	for (int index = 1; index < argc; index += 1)
+	{
+		const std::string cmd = argv[index];
+		if (cmd == "--layers" || cmd == "--animated" || cmd == "--collisions")
+		{
+			if (index + 1 >= argc)
+			{
+				LOG_WARNING("{0} requires a value", cmd);
+				print_usage();
+				return -1;
+			}
+			index += 1;
+			const std::string value = argv[index];
+			if (cmd == "--layers")
+			{
+				const auto layers = parse_int(value);
+				if (! layers || *layers < 1)
+				{
+					LOG_WARNING("{0} requires a positive number of layers, got {1}", cmd, value);
+					print_usage();
+					return -1;
+				}
+				synthetic_map.layers = *layers;
+			}
+			else
+			{
+				const auto density = parse_density(value);
+				if (! density)
+				{
+					LOG_WARNING("{0} requires a density between 0 and 1, got {1}", cmd, value);
+					print_usage();
+					return -1;
+				}
+				if (cmd == "--animated")
+				{
+					synthetic_map.animated_density = *density;
+				}
+				else
+				{
+					synthetic_map.collision_density = *density;
+				}
+			}
+		}
+		else
+		{
+			if (json_path)
+			{
+				LOG_WARNING("Results already specified as {0}: {1}", *json_path, cmd);
+				print_usage();
+				return -1;
+			}
+			else
+			{
+				json_path = cmd;
+			}
+		}
+	}
+
+	if (! json_path)
+	{
+		LOG_WARNING("The json file to write the results to is missing");
+		print_usage();
+		return -1;
+	}
+
+	// the benchmark generates its maps and doesn't need the game folder or a gpu
+	run_tiles_benchmark(*json_path, synthetic_map);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		return run(argc, argv);
+	}
+	catch (...)
+	{
+		auto x = collect_exception();
+		for (const auto& e: x.errors)
+		{
+			LOG_ERROR("- {0}", e);
+		}
+		return -1;
+	}
+}
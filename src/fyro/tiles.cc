@@ -9,9 +9,21 @@
 #include <iostream>
 #include <cmath>
 #include <optional>
-
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <functional>
+
+#include "stb_rect_pack.h"
+
+#include "fyro/assert.h"
+#include "fyro/cint.h"
+#include "fyro/cooked.h"
+#include "fyro/log.h"
 #include "fyro/render/texture.h"
 #include "fyro/render/render2.h"
+#include "fyro/render/static_quads.h"
 #include "fyro/rect.h"
 
 
@@ -24,6 +36,11 @@ int floor_to_int(float f)
 	return static_cast<int>(floorf(f));
 }
 
+int ceil_to_int(float f)
+{
+	return static_cast<int>(ceilf(f));
+}
+
 namespace
 {
 void flipY(glm::vec2* v0, glm::vec2* v1, glm::vec2* v2, glm::vec2* v3)
@@ -130,14 +147,31 @@ void doFlips(std::uint8_t bits, glm::vec2* v0, glm::vec2* v1, glm::vec2* v2, glm
 }
 }  //  namespace
 
-struct AnimationState
+bool ChunkRange::empty() const
 {
-	glm::ivec2 tileCords;
-	float startTime;
-	float currentTime;
-	tmx::Tileset::Tile animTile;
-	std::uint8_t flipFlags;
-};
+	return begin.x >= end.x || begin.y >= end.y;
+}
+
+ChunkRange get_visible_chunks(
+	const Rectf& view, const glm::ivec2& chunk_size, const glm::ivec2& chunk_count, float map_height
+)
+{
+	const auto size = glm::vec2{chunk_size};
+
+	// a chunk is visible if it overlaps the view, touching it is not enough
+	const auto first = [](float f, int count) { return std::clamp(floor_to_int(f), 0, count); };
+	const auto last = [](float f, int count) { return std::clamp(ceil_to_int(f), 0, count); };
+
+	auto r = ChunkRange{};
+	r.begin.x = first(view.left / size.x, chunk_count.x);
+	r.end.x = last(view.right / size.x, chunk_count.x);
+
+	// tmx y goes down from the top of the map
+	r.begin.y = first((map_height - view.top) / size.y, chunk_count.y);
+	r.end.y = last((map_height - view.bottom) / size.y, chunk_count.y);
+
+	return r;
+}
 
 using RenderQuad = std::array<render::Vertex2, 4>;
 
@@ -151,37 +185,203 @@ glm::vec2 transform_tile_uv(const glm::vec2& src, const glm::ivec2& size)
 	return {src.x / static_cast<float>(size.x), 1.0f - (src.y / static_cast<float>(size.y))};
 }
 
+/** The texture a tileset is drawn with, either the tileset image or a part of the map atlas */
+struct TilesetTexture
+{
+	std::shared_ptr<render::Texture> texture;  // null when cooking
+	glm::ivec2 texture_size;
+	glm::ivec2 offset;	// where the tileset image starts, in pixels from the top left
+	glm::ivec2 size;  // of the tileset image, in pixels
+};
+
+// cooked uvs are relative to the tileset image, move them to where the image is in the texture
+glm::vec2 to_texture_uv(const TilesetTexture& t, const glm::vec2& image_uv)
+{
+	const auto pixel = glm::vec2{
+		image_uv.x * static_cast<float>(t.size.x), (1.0f - image_uv.y) * static_cast<float>(t.size.y)
+	};
+	return transform_tile_uv(pixel + glm::vec2{t.offset}, t.texture_size);
+}
+
+bool is_image_texture(const TilesetTexture& t)
+{
+	return t.offset == glm::ivec2{0, 0} && t.size == t.texture_size;
+}
+
 struct ChunkArray
 {
 	std::shared_ptr<render::Texture> m_texture;
 	glm::ivec2 texSize;
+	glm::ivec2 imageOffset;
 
 	tmx::Vector2u tileSetSize;
 	glm::ivec2 tsTileCount;
 	std::uint32_t m_firstGID, m_lastGID;
 	std::vector<RenderQuad> tiles;
+	std::vector<std::optional<std::uint32_t>> tileAnimations;	// one per tile
+
+	// the animations of the tileset, played on the gpu
+	std::vector<render::TileAnimation> animations;
+	std::map<std::uint32_t, std::uint32_t> animationIndices;	// from tile id to animation
 
-	ChunkArray(std::shared_ptr<render::Texture> t, const tmx::Tileset& ts)
-		: m_texture(t)
-		, texSize(t->width, t->height)
+	// the tiles on the gpu, created on the first draw and uploaded again when the tiles change
+	std::unique_ptr<render::StaticQuads> geometry;
+	std::unique_ptr<render::StaticAnimations> animationTable;
+	bool tiles_changed = true;
+
+	ChunkArray(
+		const TilesetTexture& t,
+		const tmx::Tileset& ts,
+		const std::map<std::uint32_t, tmx::Tileset::Tile>& animTiles
+	)
+		: m_texture(t.texture)
+		, texSize(t.texture_size)
+		, imageOffset(t.offset)
 	{
 		tileSetSize = ts.getTileSize();
-		tsTileCount.x = texSize.x / static_cast<int>(tileSetSize.x);
-		tsTileCount.y = texSize.y / static_cast<int>(tileSetSize.y);
+		tsTileCount.x = t.size.x / static_cast<int>(tileSetSize.x);
+		tsTileCount.y = t.size.y / static_cast<int>(tileSetSize.y);
 		m_firstGID = ts.getFirstGID();
 		m_lastGID = ts.getLastGID();
+
+		for (const auto& [id, tile]: animTiles)
+		{
+			if (contains(id) == false || tile.animation.frames.empty())
+			{
+				continue;
+			}
+
+			auto animation = render::TileAnimation{};
+			for (const auto& frame: tile.animation.frames)
+			{
+				animation.frames.emplace_back(render::AnimationFrame{
+					getUv(frame.tileID) - getUv(id), static_cast<float>(frame.duration) / 1000.0f
+				});
+			}
+			animationIndices[id] = static_cast<std::uint32_t>(animations.size());
+			animations.emplace_back(std::move(animation));
+		}
+	}
+
+	// the uv of the top left corner of the tile
+	glm::vec2 getUv(std::uint32_t id) const
+	{
+		const auto idIndex = id - m_firstGID;
+		const auto tileIndex = glm::vec2{
+			(idIndex % static_cast<unsigned int>(tsTileCount.x)) * tileSetSize.x,
+			(idIndex / static_cast<unsigned int>(tsTileCount.x)) * tileSetSize.y
+		};
+		return transform_tile_uv(tileIndex + glm::vec2{imageOffset}, texSize);
+	}
+
+	std::optional<std::uint32_t> getAnimation(std::uint32_t id) const
+	{
+		if (const auto found = animationIndices.find(id); found != animationIndices.end())
+		{
+			return found->second;
+		}
+		return std::nullopt;
+	}
+
+	// the same frame the tile shader selects
+	glm::vec2 getUvOffset(std::uint32_t animation, float time) const
+	{
+		const auto& frames = animations[animation].frames;
+		float duration = 0.0f;
+		for (const auto& frame: frames)
+		{
+			duration += frame.duration;
+		}
+
+		const auto t = duration > 0.0f ? std::fmod(time, duration) : 0.0f;
+		float end = 0.0f;
+		for (const auto& frame: frames)
+		{
+			end += frame.duration;
+			if (t < end)
+			{
+				return frame.uv_offset;
+			}
+		}
+		return frames.back().uv_offset;
+	}
+
+	// the cooked tiles of a chunk
+	ChunkArray(const TilesetTexture& t, std::uint32_t firstGID, CookedReader* file)
+		: m_texture(t.texture)
+		, texSize(t.texture_size)
+		, imageOffset(t.offset)
+		, tileSetSize(0, 0)
+		, tsTileCount(0, 0)
+		, m_firstGID(firstGID)
+		, m_lastGID(firstGID)
+	{
+		tiles = file->read_array<RenderQuad>();
+		for (const auto animation: file->read_array<std::int32_t>())
+		{
+			tileAnimations.emplace_back(
+				animation >= 0 ? std::optional<std::uint32_t>{static_cast<std::uint32_t>(animation)}
+							   : std::nullopt
+			);
+		}
+		const auto animation_count = file->read<std::uint32_t>();
+		for (std::uint32_t index = 0; index < animation_count; index += 1)
+		{
+			animations.emplace_back(
+				render::TileAnimation{file->read_array<render::AnimationFrame>()}
+			);
+		}
+
+		if (is_image_texture(t))
+		{
+			return;
+		}
+
+		const auto zero = to_texture_uv(t, {0.0f, 0.0f});
+		for (auto& q: tiles)
+		{
+			for (auto& v: q)
+			{
+				v.texturecoord = to_texture_uv(t, v.texturecoord);
+			}
+		}
+		for (auto& animation: animations)
+		{
+			for (auto& frame: animation.frames)
+			{
+				frame.uv_offset = to_texture_uv(t, frame.uv_offset) - zero;
+			}
+		}
+	}
+
+	// the uvs are relative to the tileset image since the map is loaded without an atlas
+	void writeCooked(CookedWriter* file) const
+	{
+		file->write(m_firstGID);
+		file->write_array(tiles);
+		std::vector<std::int32_t> animation_indices;
+		for (const auto& animation: tileAnimations)
+		{
+			animation_indices.emplace_back(animation ? static_cast<std::int32_t>(*animation) : -1);
+		}
+		file->write_array(animation_indices);
+		file->write(static_cast<std::uint32_t>(animations.size()));
+		for (const auto& animation: animations)
+		{
+			file->write_array(animation.frames);
+		}
 	}
 
 	~ChunkArray() = default;
 	ChunkArray(const ChunkArray&) = delete;
 	ChunkArray& operator=(const ChunkArray&) = delete;
 
-	void reset()
+	bool contains(std::uint32_t id) const
 	{
-		tiles.clear();
+		return id >= m_firstGID && id <= m_lastGID;
 	}
 
-	void addTile(const RenderQuad& tile)
+	void addTile(const RenderQuad& tile, std::optional<std::uint32_t> animation)
 	{
 		// std::cout << "adding tile:\n";
 		// for(auto& t: tile)
@@ -189,26 +389,93 @@ struct ChunkArray
 		// 	std::cout << "    (" << t.texturecoord.x << ", " << t.texturecoord.y << ")\n";
 		// }
 		tiles.emplace_back(tile);
+		tileAnimations.emplace_back(animation);
+		tiles_changed = true;
 	}
 
-	void draw(render::SpriteBatch& batch) const
+	void draw(render::SpriteBatch& batch, float time)
 	{
-		for (const auto& q: tiles)
+		// the sort queue needs each quad, so animate them on the cpu
+		if (batch.sorting)
+		{
+			for (std::size_t index = 0; index < tiles.size(); index += 1)
+			{
+				auto q = tiles[index];
+				if (const auto animation = tileAnimations[index]; animation)
+				{
+					const auto offset = getUvOffset(*animation, time);
+					for (auto& v: q)
+					{
+						v.texturecoord += offset;
+					}
+				}
+				batch.quad(m_texture.get(), q[0], q[1], q[2], q[3]);
+			}
+			return;
+		}
+
+		if (geometry == nullptr)
+		{
+			geometry = std::make_unique<render::StaticQuads>(batch.render);
+			if (animations.empty() == false)
+			{
+				animationTable
+					= std::make_unique<render::StaticAnimations>(batch.render, animations);
+			}
+		}
+
+		if (tiles_changed)
 		{
-			batch.quad(m_texture.get(), q[0], q[1], q[2], q[3]);
+			geometry->clear();
+			for (std::size_t index = 0; index < tiles.size(); index += 1)
+			{
+				const auto& q = tiles[index];
+				geometry->add(q[0], q[1], q[2], q[3], tileAnimations[index]);
+			}
+			tiles_changed = false;
 		}
+
+		geometry->draw(&batch, *m_texture, animationTable.get(), time);
 	}
 };
 
 void add_collision(
-	MapImpl* impl, const glm::vec2& pos, const glm::vec2& size, const tmx::Tileset::Tile& tile
-);
+	std::vector<Rectf>* collisions, const glm::vec2& pos, const tmx::Tileset::Tile& tile
+)
+{
+	const auto& objects = tile.objectGroup.getObjects();
+	if (objects.empty())
+	{
+		return;
+	}
+
+	if (objects.size() != 1)
+	{
+		std::cerr << "too many collisions: " << tile.imagePath << ": "
+				  << "id=" << tile.ID << " " << tile.imagePosition.x << " " << tile.imagePosition.y
+				  << " -> " << objects.size() << "\n";
+		return;
+	}
+
+	const auto& aabb = objects[0].getAABB();
+	collisions->emplace_back(Rectf{aabb.width, aabb.height}.translate(pos.x, pos.y));
+}
+
+const TilesetTexture& get_tileset_texture(MapImpl* impl, std::uint32_t firstGID);
+
+/** The parts of a tmx tile layer that the chunks are built from */
+struct LayerTiles
+{
+	float opacity;
+	glm::vec2 offset;
+	std::vector<tmx::TileLayer::Tile> tiles;
+	std::vector<bool> hidden;  // tiles covered by opaque tiles on layers above, empty if none
+};
 
 struct Chunk
 {
 	MapImpl* owner;
 
-	std::map<std::uint32_t, tmx::Tileset::Tile> m_animTiles;  // animation catalogue
 	glm::vec2 bounds;
 
 	glm::vec2 m_position;
@@ -217,9 +484,8 @@ struct Chunk
 	glm::ivec2 mapTileSize;	 // general Tilesize of Map
 	glm::ivec2 chunkTileCount;	// chunk tilecount
 	std::vector<tmx::TileLayer::Tile>
-		m_chunkTileIDs;	 // stores all tiles in this chunk for later manipulation
+		m_chunkTileIDs;	 // the tiles of the chunk that the quads are built from
 	std::vector<glm::vec4> m_chunkColors;  // stores colors for extended color effects
-	std::vector<AnimationState> m_activeAnimations;	 // Animations to be done in this chunk
 	std::vector<std::unique_ptr<ChunkArray>> m_chunkArrays;
 
 	void setPosition(const glm::vec2& p)
@@ -232,9 +498,10 @@ struct Chunk
 		return m_position;
 	}
 
+	// only reads from the owner so chunks can be built on a worker thread
 	Chunk(
 		MapImpl* o,
-		const tmx::TileLayer& layer,
+		const LayerTiles& layer,
 		std::vector<const tmx::Tileset*> tilesets,
 		const glm::vec2& position,
 		const glm::ivec2& tileCount,
@@ -244,19 +511,16 @@ struct Chunk
 		const std::map<std::uint32_t, tmx::Tileset::Tile>& animTiles
 	)
 		: owner(o)
-		, m_animTiles(animTiles)
 		, bounds(abounds)
 	{
 		setPosition(position);
-		layerOpacity = layer.getOpacity();
+		layerOpacity = layer.opacity;
 		glm::vec4 vertColour = glm::vec4{1.0f, 1.0f, 1.0f, layerOpacity};
-		auto offset = layer.getOffset();
-		layerOffset.x = static_cast<float>(offset.x);
-		layerOffset.y = static_cast<float>(offset.y);
+		layerOffset = layer.offset;
 		chunkTileCount.x = tileCount.x;
 		chunkTileCount.y = tileCount.y;
 		mapTileSize = tileSize;
-		const auto& tileIDs = layer.getTiles();
+		const auto& tileIDs = layer.tiles;
 
 		//go through the tiles and create all arrays (for latter manipulation)
 		for (const auto& ts: tilesets)
@@ -270,7 +534,9 @@ struct Chunk
 
 			// std::cout << "loading tile texture " << ts->getImagePath() << "\n";
 			m_chunkArrays.emplace_back(
-				std::make_unique<ChunkArray>(load_texture(ts->getImagePath()), *ts)
+				std::make_unique<ChunkArray>(
+					get_tileset_texture(owner, ts->getFirstGID()), *ts, animTiles
+				)
 			);
 		}
 		int xPos = static_cast<int>(position.x / static_cast<float>(tileSize.x));
@@ -279,31 +545,127 @@ struct Chunk
 		{
 			for (auto x = xPos; x < xPos + tileCount.x; ++x)
 			{
-				auto idx = (y * rowSize + x);
-				m_chunkTileIDs.emplace_back(tileIDs[static_cast<std::size_t>(idx)]);
+				const auto idx = static_cast<std::size_t>(y * rowSize + x);
+				if (layer.hidden.empty() == false && layer.hidden[idx])
+				{
+					// never visible so no quad is needed, the collisions are extracted separately
+					m_chunkTileIDs.emplace_back(tmx::TileLayer::Tile{});
+				}
+				else
+				{
+					m_chunkTileIDs.emplace_back(tileIDs[idx]);
+				}
 				m_chunkColors.emplace_back(vertColour);
 			}
 		}
-		generateTiles(true, tilesets);
+		generateTiles();
+	}
+
+	// a cooked chunk only has the tiles to draw
+	Chunk(MapImpl* o, CookedReader* file)
+		: owner(o)
+		, bounds(0.0f, 0.0f)
+		, layerOpacity(1.0f)
+		, layerOffset(0.0f, 0.0f)
+		, mapTileSize(0, 0)
+		, chunkTileCount(0, 0)
+	{
+		setPosition(file->read<glm::vec2>());
+		const auto array_count = file->read<std::uint32_t>();
+		for (std::uint32_t index = 0; index < array_count; index += 1)
+		{
+			const auto firstGID = file->read<std::uint32_t>();
+			m_chunkArrays.emplace_back(std::make_unique<ChunkArray>(
+				get_tileset_texture(owner, firstGID), firstGID, file
+			));
+		}
+	}
+
+	void writeCooked(CookedWriter* file) const
+	{
+		file->write(m_position);
+		file->write(static_cast<std::uint32_t>(m_chunkArrays.size()));
+		for (const auto& ca: m_chunkArrays)
+		{
+			ca->writeCooked(file);
+		}
 	}
 
 	~Chunk() = default;
 	Chunk(const Chunk&) = delete;
 	Chunk& operator=(const Chunk&) = delete;
 
-	void generateTiles(bool registerAnimation, std::vector<const tmx::Tileset*> tilesets)
+	// estimated bytes used by the chunk, the tiles are counted twice since they are also on the gpu
+	std::size_t getMemoryUsage() const
 	{
-		if (registerAnimation)
+		std::size_t r = sizeof(Chunk) + m_chunkTileIDs.size() * sizeof(tmx::TileLayer::Tile)
+					  + m_chunkColors.size() * sizeof(glm::vec4);
+		for (const auto& ca: m_chunkArrays)
 		{
-			m_activeAnimations.clear();
+			r += sizeof(ChunkArray) + ca->tiles.size() * sizeof(RenderQuad) * 2
+			   + ca->tileAnimations.size() * sizeof(std::optional<std::uint32_t>);
 		}
+		return r;
+	}
+
+	// where the tile at the map tile coordinate is placed, in tmx space
+	glm::vec2 getTileOffset(const ChunkArray& ca, int x, int y) const
+	{
+		return {
+			x * mapTileSize.x,
+			y * mapTileSize.y + mapTileSize.y - static_cast<int>(ca.tileSetSize.y)
+		};
+	}
 
-		std::size_t tileset_index = 0;
+	// the quad of the tile at the map tile coordinate, idx is the index of the tile in the chunk
+	RenderQuad createQuad(const ChunkArray& ca, int x, int y, std::size_t idx) const
+	{
+		const auto tileOffset = getTileOffset(ca, x, y);
+
+		auto idIndex = m_chunkTileIDs[idx].ID - ca.m_firstGID;
+		const auto tileIndex = glm::vec2{
+			(idIndex % static_cast<unsigned int>(ca.tsTileCount.x)) * ca.tileSetSize.x,
+			(idIndex / static_cast<unsigned int>(ca.tsTileCount.x)) * ca.tileSetSize.y
+		} + glm::vec2{ca.imageOffset};
+		RenderQuad tile
+			= {::render::Vertex2{
+				   transform_tile_pos(tileOffset + glm::vec2(0.f, ca.tileSetSize.y), bounds),
+				   m_chunkColors[idx],
+				   transform_tile_uv(tileIndex + glm::vec2(0.f, ca.tileSetSize.y), ca.texSize)
+			   },
+			   ::render::Vertex2{
+				   transform_tile_pos(
+					   tileOffset + glm::vec2(ca.tileSetSize.x, ca.tileSetSize.y), bounds
+				   ),
+				   m_chunkColors[idx],
+				   transform_tile_uv(
+					   tileIndex + glm::vec2(ca.tileSetSize.x, ca.tileSetSize.y), ca.texSize
+				   )
+			   },
+			   ::render::Vertex2{
+				   transform_tile_pos(tileOffset + glm::vec2(ca.tileSetSize.x, 0.f), bounds),
+				   m_chunkColors[idx],
+				   transform_tile_uv(tileIndex + glm::vec2(ca.tileSetSize.x, 0.f), ca.texSize)
+			   },
+			   ::render::Vertex2{
+				   transform_tile_pos(tileOffset, bounds),
+				   m_chunkColors[idx],
+				   transform_tile_uv(tileIndex, ca.texSize)
+			   }};
+		doFlips(
+			m_chunkTileIDs[idx].flipFlags,
+			&tile[0].texturecoord,
+			&tile[1].texturecoord,
+			&tile[2].texturecoord,
+			&tile[3].texturecoord
+		);
+		return tile;
+	}
+
+	void generateTiles()
+	{
 		for (const auto& ca: m_chunkArrays)
 		{
-			const tmx::Tileset* tset = tilesets.empty() ? nullptr : tilesets[tileset_index];
-			tileset_index += 1;
-
 			std::size_t idx = 0;
 			int xPos = static_cast<int>(getPosition().x / static_cast<float>(mapTileSize.x));
 			int yPos = static_cast<int>(getPosition().y / static_cast<float>(mapTileSize.y));
@@ -314,79 +676,8 @@ struct Chunk
 					if (idx < m_chunkTileIDs.size() && m_chunkTileIDs[idx].ID >= ca->m_firstGID
 						&& m_chunkTileIDs[idx].ID <= ca->m_lastGID)
 					{
-						if (registerAnimation
-							&& m_animTiles.find(m_chunkTileIDs[idx].ID) != m_animTiles.end())
-						{
-							AnimationState as;
-							as.animTile = m_animTiles[m_chunkTileIDs[idx].ID];
-							as.startTime = 0.0f;
-							as.tileCords = glm::ivec2(x, y);
-							m_activeAnimations.push_back(as);
-						}
-
-						glm::vec2 tileOffset{
-							x * mapTileSize.x,
-							y * mapTileSize.y + mapTileSize.y - static_cast<int>(ca->tileSetSize.y)
-						};
-
-						auto idIndex = m_chunkTileIDs[idx].ID - ca->m_firstGID;
-						glm::vec2 tileIndex{
-							(idIndex % static_cast<unsigned int>(ca->tsTileCount.x))
-								* ca->tileSetSize.x,
-							(idIndex / static_cast<unsigned int>(ca->tsTileCount.x))
-								* ca->tileSetSize.y
-						};
-						RenderQuad tile
-							= {::render::Vertex2{
-								   transform_tile_pos(
-									   tileOffset + glm::vec2(0.f, ca->tileSetSize.y), bounds
-								   ),
-								   m_chunkColors[idx],
-								   transform_tile_uv(
-									   tileIndex + glm::vec2(0.f, ca->tileSetSize.y), ca->texSize
-								   )
-							   },
-							   ::render::Vertex2{
-								   transform_tile_pos(
-									   tileOffset + glm::vec2(ca->tileSetSize.x, ca->tileSetSize.y),
-									   bounds
-								   ),
-								   m_chunkColors[idx],
-								   transform_tile_uv(
-									   tileIndex + glm::vec2(ca->tileSetSize.x, ca->tileSetSize.y),
-									   ca->texSize
-								   )
-							   },
-							   ::render::Vertex2{
-								   transform_tile_pos(
-									   tileOffset + glm::vec2(ca->tileSetSize.x, 0.f), bounds
-								   ),
-								   m_chunkColors[idx],
-								   transform_tile_uv(
-									   tileIndex + glm::vec2(ca->tileSetSize.x, 0.f), ca->texSize
-								   )
-							   },
-							   ::render::Vertex2{
-								   transform_tile_pos(tileOffset, bounds),
-								   m_chunkColors[idx],
-								   transform_tile_uv(tileIndex, ca->texSize)
-							   }};
-						doFlips(
-							m_chunkTileIDs[idx].flipFlags,
-							&tile[0].texturecoord,
-							&tile[1].texturecoord,
-							&tile[2].texturecoord,
-							&tile[3].texturecoord
-						);
-						ca->addTile(tile);
-
-						add_collision(
-							owner,
-							transform_tile_pos(
-								tileOffset + glm::vec2(0.f, ca->tileSetSize.y), bounds
-							),
-							bounds,
-							*tset->getTile(m_chunkTileIDs[idx].ID)
+						ca->addTile(
+							createQuad(*ca, x, y, idx), ca->getAnimation(m_chunkTileIDs[idx].ID)
 						);
 					}
 					idx++;
@@ -395,39 +686,115 @@ struct Chunk
 		}
 	}
 
-	void setTile(int x, int y, tmx::TileLayer::Tile tile, bool refresh)
+	bool empty() const
 	{
-		m_chunkTileIDs[calcIndexFrom(x, y)] = tile;
+		return m_chunkArrays.empty();
+	}
 
-		if (refresh)
+	void draw(render::SpriteBatch& batch, float time)
+	{
+		// states.transform *= getTransform();
+		for (const auto& a: m_chunkArrays)
 		{
-			for (const auto& ca: m_chunkArrays)
-			{
-				ca->reset();
-			}
-			generateTiles(false, {});
+			a->draw(batch, time);
 		}
 	}
+};
 
-	std::size_t calcIndexFrom(int x, int y) const
-	{
-		return static_cast<std::size_t>(x + y * chunkTileCount.x);
-	}
+/** Everything needed to build the chunks of a layer after the tmx map is gone */
+struct ChunkSource
+{
+	MapImpl* owner;
+	LayerTiles layer;
+	std::vector<tmx::Tileset> tilesets;	 // the tilesets used by the layer
+	std::map<std::uint32_t, tmx::Tileset::Tile> animTiles;
+	glm::ivec2 tileSize;
+	int rowSize;
+	glm::vec2 bounds;
+	glm::ivec2 chunkSize;
 
-	bool empty() const
+	// safe to call from a worker thread, the gpu buffers are created when the chunk is drawn
+	std::unique_ptr<Chunk> build(int x, int y) const
 	{
-		return m_chunkArrays.empty();
+		std::vector<const tmx::Tileset*> usedTileSets;
+		for (const auto& ts: tilesets)
+		{
+			usedTileSets.emplace_back(&ts);
+		}
+
+		// calculate size of each Chunk (clip against map)
+		glm::vec2 tileCount{
+			static_cast<float>(chunkSize.x) / static_cast<float>(tileSize.x),
+			static_cast<float>(chunkSize.y) / static_cast<float>(tileSize.y)
+		};
+		if (static_cast<float>((x + 1) * chunkSize.x) > bounds.x)
+		{
+			tileCount.x = (bounds.x - static_cast<float>(x * chunkSize.x))
+						/ static_cast<float>(tileSize.x);
+		}
+		if (static_cast<float>((y + 1) * chunkSize.y) > bounds.y)
+		{
+			tileCount.y = (bounds.y - static_cast<float>(y * chunkSize.y))
+						/ static_cast<float>(tileSize.y);
+		}
+
+		return std::make_unique<Chunk>(
+			owner,
+			layer,
+			usedTileSets,
+			glm::vec2(x * chunkSize.x, y * chunkSize.y),
+			tileCount,
+			tileSize,
+			rowSize,
+			bounds,
+			animTiles
+		);
 	}
+};
 
-	void draw(render::SpriteBatch& batch) const
+// the collisions of the tiles in the layer, only reads from the source so it can run on a worker
+std::vector<Rectf> get_layer_collisions(const ChunkSource& source)
+{
+	std::vector<Rectf> collisions;
+	const auto& tiles = source.layer.tiles;
+	for (std::size_t index = 0; index < tiles.size(); index += 1)
 	{
-		// states.transform *= getTransform();
-		for (const auto& a: m_chunkArrays)
+		const auto id = tiles[index].ID;
+		if (id == 0)
+		{
+			continue;
+		}
+
+		for (const auto& ts: source.tilesets)
 		{
-			a->draw(batch);
+			if (ts.getImagePath().empty() || id < ts.getFirstGID() || id > ts.getLastGID())
+			{
+				continue;
+			}
+
+			const auto* tile = ts.getTile(id);
+			if (tile == nullptr)
+			{
+				continue;
+			}
+
+			// the collision is placed at the bottom left of the tile
+			const auto x = Csizet_to_int(index) % source.rowSize;
+			const auto y = Csizet_to_int(index) / source.rowSize;
+			add_collision(
+				&collisions,
+				transform_tile_pos(
+					glm::vec2{x * source.tileSize.x, (y + 1) * source.tileSize.y}, source.bounds
+				),
+				*tile
+			);
 		}
 	}
-};
+	return collisions;
+}
+
+// number of chunks a streamed layer builds on worker threads at the same time
+constexpr std::size_t max_chunk_builds = 4;
 
 struct MapLayer
 {
@@ -436,10 +803,26 @@ struct MapLayer
 	glm::ivec2 m_MapTileSize;  // general Tilesize of Map
 	glm::vec2 m_globalBounds = {0.0f, 0.0f};
 
-	std::vector<std::unique_ptr<Chunk>> m_chunks;
+	std::vector<std::unique_ptr<Chunk>> m_chunks;  // null if the chunk is streamed and not built
 	mutable std::vector<Chunk*> m_visibleChunks;
-
-	MapLayer(MapImpl* owner, const tmx::Map& map, std::size_t idx)
+	float m_time = 0.0f;  // seconds since the layer was loaded, drives the tile animations
+
+	// streaming, the chunks are built when the view gets near them and evicted when over the budget
+	std::shared_ptr<const ChunkSource> m_source;  // null when cooked or all chunks are built
+	std::size_t m_budget = 0;	 // in bytes, 0 if the layer isn't streamed
+	std::size_t m_residentBytes = 0;
+	std::uint64_t m_frame = 0;
+	std::vector<std::uint64_t> m_lastUsed;	// the last frame each chunk was visible
+	std::map<std::size_t, std::future<std::unique_ptr<Chunk>>> m_building;
+
+	/// the chunks are built later, by buildChunk or when streamed if the budget isn't 0
+	MapLayer(
+		MapImpl* owner,
+		const tmx::Map& map,
+		std::size_t idx,
+		std::size_t budget,
+		std::vector<bool> hidden
+	)
 	{
 		const auto& layers = map.getLayers();
 
@@ -463,13 +846,27 @@ struct MapLayer
 		auto mapSize = map.getBounds();
 		m_globalBounds = glm::vec2{mapSize.width, mapSize.height};
 
+		auto source = std::make_shared<ChunkSource>();
+		source->owner = owner;
+		const auto offset = layer.getOffset();
+		source->layer = LayerTiles{
+			layer.getOpacity(),
+			glm::vec2{static_cast<float>(offset.x), static_cast<float>(offset.y)},
+			layer.getTiles(),
+			std::move(hidden)
+		};
+		source->animTiles = map.getAnimatedTiles();
+		source->tileSize = tileSize;
+		source->rowSize = static_cast<int>(map.getTileCount().x);
+		source->bounds = m_globalBounds;
+		source->chunkSize = m_chunkSize;
+
 		// create chunks
 		{
 			//look up all the tile sets and load the textures
 			const auto& tileSets = map.getTilesets();
 			const auto& layerIDs = layer.getTiles();
 			std::uint32_t maxID = std::numeric_limits<std::uint32_t>::max();
-			std::vector<const tmx::Tileset*> usedTileSets;
 
 			for (auto i = tileSets.rbegin(); i != tileSets.rend(); ++i)
 			{
@@ -477,16 +874,16 @@ struct MapLayer
 				{
 					if (tile.ID >= i->getFirstGID() && tile.ID < maxID)
 					{
-						usedTileSets.push_back(&(*i));
+						source->tilesets.push_back(*i);
 						break;
 					}
 				}
 				maxID = i->getFirstGID();
 			}
 
-			for (const auto& ts: usedTileSets)
+			for (const auto& ts: source->tilesets)
 			{
-				if (ts->hasTransparency())
+				if (ts.hasTransparency())
 				{
 					throw "unable to support transparent textures";
 					// auto transparency = ts->getTransparencyColour();
@@ -502,141 +899,270 @@ struct MapLayer
 			m_chunkCount.y
 				= static_cast<int>(std::ceil(bounds.height / static_cast<float>(m_chunkSize.y)));
 
-			for (int y = 0; y < m_chunkCount.y; ++y)
+			const auto chunk_count = Cint_to_sizet(m_chunkCount.x * m_chunkCount.y);
+			m_source = source;
+			m_budget = budget;
+			m_chunks.resize(chunk_count);
+			if (budget > 0)
 			{
-				glm::vec2 tileCount{
-					static_cast<float>(m_chunkSize.x) / static_cast<float>(tileSize.x),
-					static_cast<float>(m_chunkSize.y) / static_cast<float>(tileSize.y)
-				};
-				for (int x = 0; x < m_chunkCount.x; ++x)
-				{
-					// calculate size of each Chunk (clip against map)
-					if (static_cast<float>((x + 1) * m_chunkSize.x) > bounds.width)
-					{
-						tileCount.x = (bounds.width - static_cast<float>(x * m_chunkSize.x))
-									/ static_cast<float>(map.getTileSize().x);
-					}
-					if (static_cast<float>((y + 1) * m_chunkSize.y) > bounds.height)
-					{
-						tileCount.y = (bounds.height - static_cast<float>(y * m_chunkSize.y))
-									/ static_cast<float>(map.getTileSize().y);
-					}
-					m_chunks.emplace_back(std::make_unique<Chunk>(
-						owner,
-						layer,
-						usedTileSets,
-						glm::vec2(x * m_chunkSize.x, y * m_chunkSize.y),
-						tileCount,
-						tileSize,
-						map.getTileCount().x,
-						m_globalBounds,
-						map.getAnimatedTiles()
-					));
-				}
+				m_lastUsed.resize(chunk_count, 0);
+			}
+		}
+	}
+
+	MapLayer(MapImpl* owner, CookedReader* file)
+		: m_chunkSize(file->read<glm::ivec2>())
+		, m_chunkCount(file->read<glm::ivec2>())
+		, m_MapTileSize(file->read<glm::ivec2>())
+		, m_globalBounds(file->read<glm::vec2>())
+	{
+		const auto chunk_count = file->read<std::uint32_t>();
+		for (std::uint32_t index = 0; index < chunk_count; index += 1)
+		{
+			m_chunks.emplace_back(std::make_unique<Chunk>(owner, file));
+		}
+	}
+
+	void writeCooked(CookedWriter* file) const
+	{
+		ASSERT(m_budget == 0 && "streamed layers can't be cooked");
+		file->write(m_chunkSize);
+		file->write(m_chunkCount);
+		file->write(m_MapTileSize);
+		file->write(m_globalBounds);
+		file->write(static_cast<std::uint32_t>(m_chunks.size()));
+		for (const auto& chunk: m_chunks)
+		{
+			chunk->writeCooked(file);
+		}
+	}
+
+	// wait for the chunks that are still being built, they read the map the layer belongs to
+	~MapLayer()
+	{
+		for (auto& building: m_building)
+		{
+			if (building.second.valid())
+			{
+				building.second.wait();
 			}
 		}
 	}
 
-	~MapLayer() = default;
 	MapLayer(const MapLayer&) = delete;
 	MapLayer& operator=(const MapLayer&) = delete;
 
 	MapLayer(MapLayer&&) = default;
 	MapLayer& operator=(MapLayer&&) = default;
 
+	// the tile animations are played by the tile shader, only the time needs to advance
 	void update(float elapsed)
 	{
-		auto setTile = [this](int x, int y, tmx::TileLayer::Tile tile)
-		{
-			bool refresh = true;
-			int chunkX = floor_to_int(
-				static_cast<float>(x * m_MapTileSize.x) / static_cast<float>(m_chunkSize.x)
-			);
-			int chunkY = floor_to_int(
-				static_cast<float>(y * m_MapTileSize.y) / static_cast<float>(m_chunkSize.y)
-			);
-			const int chtax = x * m_MapTileSize.x - chunkX * m_chunkSize.x;
-			const int chtay = y * m_MapTileSize.y - chunkY * m_chunkSize.y;
-			glm::ivec2 chunkLocale = {
-				static_cast<int>(static_cast<float>(chtax) / static_cast<float>(m_MapTileSize.x)),
-				static_cast<int>(static_cast<float>(chtay) / static_cast<float>(m_MapTileSize.y))
-			};
-			const auto index = chunkX + chunkY * m_chunkCount.x;
-			const auto& selectedChunk = m_chunks[static_cast<size_t>(index)];
-			// const auto& selectedChunk = getChunkAndTransform(x, y, chunkLocale);
-			selectedChunk->setTile(chunkLocale.x, chunkLocale.y, tile, refresh);
-		};
+		m_time += elapsed;
+	}
 
-		for (auto& c: m_visibleChunks)
+	std::size_t getIndex(int x, int y) const
+	{
+		return static_cast<std::size_t>(y * m_chunkCount.x + x);
+	}
+
+	std::size_t getMemoryUsage() const
+	{
+		std::size_t r = m_chunks.size() * sizeof(std::unique_ptr<Chunk>);
+		for (const auto& chunk: m_chunks)
 		{
-			for (AnimationState& as: c->m_activeAnimations)
+			if (chunk != nullptr)
 			{
-				as.currentTime += elapsed;
-
-				tmx::TileLayer::Tile tile;
-				float animTime = 0;
-				auto x = as.animTile.animation.frames.begin();
-				while (animTime < as.currentTime)
-				{
-					if (x == as.animTile.animation.frames.end())
-					{
-						x = as.animTile.animation.frames.begin();
-						as.currentTime -= animTime;
-						animTime = 0;
-					}
-
-					tile.ID = x->tileID;
-					animTime += static_cast<float>(x->duration) / 1000.0f;
-					x++;
-				}
-
-				setTile(as.tileCords.x, as.tileCords.y, tile);
+				r += chunk->getMemoryUsage();
 			}
 		}
+		return r;
 	}
 
-	void draw(render::SpriteBatch& batch, const Rectf& view) const
+	bool isStreamed() const
 	{
-		// update visibility:
-		// calc view coverage and draw nearest chunks
-		{
-			const int left = static_cast<int>(view.left);
-			const int bottom = static_cast<int>(view.bottom);
-			const int right = static_cast<int>(view.right);
-			const int top = static_cast<int>(view.top);
+		return m_budget > 0;
+	}
 
-			std::vector<Chunk*> visible;
-			for (auto y = bottom; y < top; ++y)
-			{
-				for (auto x = left; x < right; ++x)
-				{
-					std::size_t idx = static_cast<std::size_t>(y * m_chunkCount.x + x);
-					if (idx < m_chunks.size() && ! m_chunks[idx]->empty())
-					{
-						visible.push_back(m_chunks[idx].get());
-					}
-				}
-			}
+	/// build a chunk of a layer that isn't streamed, different chunks can be built on different
+	/// threads at the same time
+	void buildChunk(std::size_t index)
+	{
+		ASSERT(isStreamed() == false);
+		const auto x = Csizet_to_int(index) % m_chunkCount.x;
+		const auto y = Csizet_to_int(index) / m_chunkCount.x;
+		m_chunks[index] = m_source->build(x, y);
+	}
 
-			std::swap(m_visibleChunks, visible);
+	/// called when all chunks are built, the tiles are no longer needed
+	void finishBuilding()
+	{
+		if (isStreamed() == false)
+		{
+			m_source.reset();
+		}
+	}
+
+	void addChunk(std::size_t index, std::unique_ptr<Chunk> chunk)
+	{
+		m_residentBytes += chunk->getMemoryUsage();
+		m_chunks[index] = std::move(chunk);
+	}
+
+	// build the chunks near the view and evict the chunks that were seen the longest time ago
+	void stream(const Rectf& view, const ChunkRange& visible)
+	{
+		m_frame += 1;
+
+		for (auto building = m_building.begin(); building != m_building.end();)
+		{
+			if (building->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			{
+				addChunk(building->first, building->second.get());
+				building = m_building.erase(building);
+			}
+			else
+			{
+				++building;
+			}
+		}
+
+		// start building the chunks around the view before they are visible
+		const auto margin = glm::vec2{m_chunkSize};
+		const auto near = get_visible_chunks(
+			Rectf{
+				view.left - margin.x,
+				view.bottom - margin.y,
+				view.right + margin.x,
+				view.top + margin.y
+			},
+			m_chunkSize,
+			m_chunkCount,
+			m_globalBounds.y
+		);
+		for (auto y = near.begin.y; y < near.end.y; ++y)
+		{
+			for (auto x = near.begin.x; x < near.end.x; ++x)
+			{
+				const auto index = getIndex(x, y);
+				if (m_chunks[index] != nullptr || m_building.find(index) != m_building.end()
+					|| m_building.size() >= max_chunk_builds)
+				{
+					continue;
+				}
+				m_building.emplace(
+					index,
+					std::async(
+						std::launch::async,
+						[source = m_source, x, y]() { return source->build(x, y); }
+					)
+				);
+			}
+		}
+
+		// the visible chunks can't wait, finish them now
+		for (auto y = visible.begin.y; y < visible.end.y; ++y)
+		{
+			for (auto x = visible.begin.x; x < visible.end.x; ++x)
+			{
+				const auto index = getIndex(x, y);
+				m_lastUsed[index] = m_frame;
+				if (m_chunks[index] != nullptr)
+				{
+					continue;
+				}
+
+				if (auto building = m_building.find(index); building != m_building.end())
+				{
+					addChunk(index, building->second.get());
+					m_building.erase(building);
+				}
+				else
+				{
+					addChunk(index, m_source->build(x, y));
+				}
+			}
+		}
+
+		while (m_residentBytes > m_budget)
+		{
+			std::optional<std::size_t> oldest;
+			for (std::size_t index = 0; index < m_chunks.size(); index += 1)
+			{
+				const auto x = Csizet_to_int(index) % m_chunkCount.x;
+				const auto y = Csizet_to_int(index) / m_chunkCount.x;
+				const auto is_near
+					= x >= near.begin.x && x < near.end.x && y >= near.begin.y && y < near.end.y;
+				if (m_chunks[index] == nullptr || is_near)
+				{
+					continue;
+				}
+				if (! oldest || m_lastUsed[index] < m_lastUsed[*oldest])
+				{
+					oldest = index;
+				}
+			}
+
+			// everything that is left is near the view
+			if (! oldest)
+			{
+				break;
+			}
+
+			m_residentBytes -= m_chunks[*oldest]->getMemoryUsage();
+			m_chunks[*oldest].reset();
+		}
+	}
+
+	void draw(render::SpriteBatch& batch, const Rectf& view)
+	{
+		// update visibility:
+		// calc view coverage and draw nearest chunks
+		{
+			const auto range
+				= get_visible_chunks(view, m_chunkSize, m_chunkCount, m_globalBounds.y);
+
+			if (isStreamed())
+			{
+				stream(view, range);
+			}
+
+			m_visibleChunks.clear();
+			for (auto y = range.begin.y; y < range.end.y; ++y)
+			{
+				for (auto x = range.begin.x; x < range.end.x; ++x)
+				{
+					auto& chunk = m_chunks[getIndex(x, y)];
+					if (chunk != nullptr && ! chunk->empty())
+					{
+						m_visibleChunks.push_back(chunk.get());
+					}
+				}
+			}
 		}
 
 
 		for (const auto& c: m_visibleChunks)
 		{
-			c->draw(batch);
+			c->draw(batch, m_time);
 			// rt.draw(*c, states);
 		}
 	}
 };
 
-std::optional<MapLayer> make_layer(MapImpl* owner, const tmx::Map& map, std::size_t idx)
+std::optional<MapLayer> make_layer(
+	MapImpl* owner,
+	const tmx::Map& map,
+	std::size_t idx,
+	std::size_t budget,
+	std::vector<bool> hidden
+)
 {
 	const auto& layers = map.getLayers();
 	if (map.getOrientation() == tmx::Orientation::Orthogonal && idx < layers.size()
 		&& layers[idx]->getType() == tmx::Layer::Type::Tile)
 	{
-		return MapLayer{owner, map, idx};
+		return MapLayer{owner, map, idx, budget, std::move(hidden)};
 	}
 	else
 	{
@@ -644,33 +1170,441 @@ std::optional<MapLayer> make_layer(MapImpl* owner, const tmx::Map& map, std::siz
 	}
 }
 
+/** The image of a tileset */
+struct TilesetImage
+{
+	std::uint32_t first_gid;
+	std::string path;
+	glm::ivec2 size;  // as written in the tmx file
+};
+
 struct MapImpl
 {
-	std::vector<MapLayer> layers;
 	std::vector<Rectf> collisions;
 	std::optional<Rectf> bounds;
+	std::map<std::uint32_t, TilesetTexture> tileset_textures;	// from the first gid of the tileset
+
+	// kept for cooking
+	std::vector<TilesetImage> tileset_images;
+	bool atlas = false;
+
+	// last so the layers are destroyed first, the chunks that are still being built read the
+	// tileset textures
+	std::vector<MapLayer> layers;
 };
 
-void add_collision(
-	MapImpl* impl, const glm::vec2& pos, const glm::vec2&, const tmx::Tileset::Tile& tile
+const TilesetTexture& get_tileset_texture(MapImpl* impl, std::uint32_t firstGID)
+{
+	const auto found = impl->tileset_textures.find(firstGID);
+	ASSERT(found != impl->tileset_textures.end());
+	return found->second;
+}
+
+constexpr int max_atlas_size = 4096;
+
+std::optional<AtlasLayout> get_atlas_layout(const std::vector<glm::ivec2>& sizes, int max_size)
+{
+	for (int size = 1; size <= max_size; size *= 2)
+	{
+		std::vector<stbrp_node> nodes(Cint_to_sizet(size));
+		stbrp_context context;
+		stbrp_init_target(&context, size, size, nodes.data(), size);
+
+		std::vector<stbrp_rect> rects;
+		for (std::size_t index = 0; index < sizes.size(); index += 1)
+		{
+			stbrp_rect r = {};
+			r.id = Csizet_to_int(index);
+			r.w = sizes[index].x;
+			r.h = sizes[index].y;
+			rects.emplace_back(r);
+		}
+
+		if (stbrp_pack_rects(&context, rects.data(), Csizet_to_int(rects.size())) == 1)
+		{
+			auto layout = AtlasLayout{{size, size}, {}};
+			layout.offsets.resize(sizes.size());
+			for (const auto& r: rects)
+			{
+				layout.offsets[Cint_to_sizet(r.id)] = {r.x, r.y};
+			}
+			return layout;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::vector<TilesetImage> get_tileset_images(const tmx::Map& map)
+{
+	std::vector<TilesetImage> r;
+	for (const auto& ts: map.getTilesets())
+	{
+		if (ts.getImagePath().empty())
+		{
+			continue;
+		}
+
+		const auto size = ts.getImageSize();
+		r.emplace_back(TilesetImage{
+			ts.getFirstGID(),
+			ts.getImagePath(),
+			glm::ivec2{static_cast<int>(size.x), static_cast<int>(size.y)}
+		});
+	}
+	return r;
+}
+
+bool get_bool_property(const tmx::Map& map, const std::string& name)
+{
+	for (const auto& prop: map.getProperties())
+	{
+		if (prop.getName() == name && prop.getType() == tmx::Property::Type::Boolean)
+		{
+			return prop.getBoolValue();
+		}
+	}
+	return false;
+}
+
+bool is_atlas_requested(const tmx::Map& map)
+{
+	return get_bool_property(map, "atlas");
+}
+
+// the tiles of the tileset are drawn exactly over the map tile they are placed in
+bool is_drawn_in_cell(const tmx::Tileset& ts, const glm::ivec2& map_tile_size)
+{
+	const auto tile_size = glm::ivec2{
+		static_cast<int>(ts.getTileSize().x), static_cast<int>(ts.getTileSize().y)
+	};
+	const auto tile_offset = ts.getTileOffset();
+	return tile_size == map_tile_size && tile_offset.x == 0 && tile_offset.y == 0;
+}
+
+// the tiles that fill the whole map tile without a single transparent pixel, from the first gid
+std::vector<bool> get_opaque_tiles(const tmx::Tileset& ts, const glm::ivec2& map_tile_size)
+{
+	if (ts.getImagePath().empty() || is_drawn_in_cell(ts, map_tile_size) == false)
+	{
+		return {};
+	}
+
+	const auto tile_size = map_tile_size;
+
+	const auto image = load_image(ts.getImagePath());
+	if (image.pixels.empty())
+	{
+		return {};
+	}
+
+	// laid out like the uvs of the chunks
+	const auto columns = image.width / tile_size.x;
+	const auto rows = image.height / tile_size.y;
+	std::vector<bool> r(Cint_to_sizet(columns * rows), true);
+	for (int index = 0; index < columns * rows; index += 1)
+	{
+		const auto left = (index % columns) * tile_size.x;
+		const auto top = (index / columns) * tile_size.y;
+		for (int y = top; y < top + tile_size.y && r[Cint_to_sizet(index)]; y += 1)
+		{
+			for (int x = left; x < left + tile_size.x; x += 1)
+			{
+				if (image.pixels[Cint_to_sizet((y * image.width + x) * 4 + 3)] != 255)
+				{
+					r[Cint_to_sizet(index)] = false;
+					break;
+				}
+			}
+		}
+	}
+
+	// an animation might show a transparent frame
+	for (const auto& tile: ts.getTiles())
+	{
+		if (tile.animation.frames.empty() == false && tile.ID < r.size())
+		{
+			r[tile.ID] = false;
+		}
+	}
+
+	return r;
+}
+
+std::vector<std::vector<bool>> get_hidden_tiles(
+	const tmx::Map& map, const std::vector<std::vector<bool>>& opaque_tiles
 )
 {
-	const auto& objects = tile.objectGroup.getObjects();
-	if (objects.empty())
+	const auto& layers = map.getLayers();
+	std::vector<std::vector<bool>> r(layers.size());
+	if (map.getOrientation() != tmx::Orientation::Orthogonal)
+	{
+		return r;
+	}
+
+	const auto map_tile_size = glm::ivec2{
+		static_cast<int>(map.getTileSize().x), static_cast<int>(map.getTileSize().y)
+	};
+	const auto& tilesets = map.getTilesets();
+	std::vector<bool> in_cell;
+	for (const auto& ts: tilesets)
+	{
+		in_cell.emplace_back(is_drawn_in_cell(ts, map_tile_size));
+	}
+	const auto get_tileset = [&](const tmx::TileLayer::Tile& tile) -> std::optional<std::size_t>
+	{
+		for (std::size_t index = 0; index < tilesets.size(); index += 1)
+		{
+			const auto& ts = tilesets[index];
+			if (tile.ID >= ts.getFirstGID() && tile.ID <= ts.getLastGID())
+			{
+				return index;
+			}
+		}
+		return std::nullopt;
+	};
+	const auto is_opaque = [&](const tmx::TileLayer::Tile& tile)
+	{
+		const auto index = get_tileset(tile);
+		if (! index || *index >= opaque_tiles.size())
+		{
+			return false;
+		}
+		const auto tile_index = tile.ID - tilesets[*index].getFirstGID();
+		return tile_index < opaque_tiles[*index].size() && opaque_tiles[*index][tile_index];
+	};
+	// a larger or offset tile is drawn outside of the cell that is covered
+	const auto is_in_cell = [&](const tmx::TileLayer::Tile& tile)
+	{
+		const auto index = get_tileset(tile);
+		return index && in_cell[*index];
+	};
+
+	const auto tile_count = map.getTileCount();
+	const auto cells = static_cast<std::size_t>(tile_count.x) * tile_count.y;
+	std::vector<bool> covered(cells, false);
+	std::size_t hidden_count = 0;
+	for (auto layer_index = layers.size(); layer_index > 0; layer_index -= 1)
+	{
+		const auto& layer = layers[layer_index - 1];
+		if (layer->getType() != tmx::Layer::Type::Tile)
+		{
+			continue;
+		}
+
+		const auto& tile_layer = layer->getLayerAs<tmx::TileLayer>();
+		const auto& tiles = tile_layer.getTiles();
+		if (tiles.size() != cells)
+		{
+			continue;
+		}
+
+		// a transparent or moved layer doesn't cover anything and a moved layer isn't covered
+		const auto offset = tile_layer.getOffset();
+		const auto is_moved = offset.x != 0 || offset.y != 0;
+
+		std::vector<bool> hidden(cells, false);
+		bool has_hidden = false;
+		for (std::size_t cell = 0; cell < cells && is_moved == false; cell += 1)
+		{
+			if (covered[cell] && tiles[cell].ID != 0 && is_in_cell(tiles[cell]))
+			{
+				hidden[cell] = true;
+				has_hidden = true;
+				hidden_count += 1;
+			}
+		}
+		if (has_hidden)
+		{
+			r[layer_index - 1] = std::move(hidden);
+		}
+
+		if (tile_layer.getOpacity() < 1.0f || is_moved)
+		{
+			continue;
+		}
+		for (std::size_t cell = 0; cell < cells; cell += 1)
+		{
+			if (is_opaque(tiles[cell]))
+			{
+				covered[cell] = true;
+			}
+		}
+	}
+
+	LOG_INFO("Culled {0} tiles hidden by opaque tiles", hidden_count);
+	return r;
+}
+
+// the hidden tiles of each layer, empty if the culling isn't requested with the bool map property
+// "cull_hidden_tiles"
+std::vector<std::vector<bool>> get_hidden_tiles(const tmx::Map& map)
+{
+	if (get_bool_property(map, "cull_hidden_tiles") == false)
+	{
+		return std::vector<std::vector<bool>>(map.getLayers().size());
+	}
+
+	const auto map_tile_size = glm::ivec2{
+		static_cast<int>(map.getTileSize().x), static_cast<int>(map.getTileSize().y)
+	};
+	std::vector<std::vector<bool>> opaque_tiles;
+	for (const auto& ts: map.getTilesets())
 	{
+		opaque_tiles.emplace_back(get_opaque_tiles(ts, map_tile_size));
+	}
+	return get_hidden_tiles(map, opaque_tiles);
+}
+
+// the memory the chunks of each layer may use, 0 if all chunks are built when loaded
+// only the chunk geometry is streamed, the rest of the load still goes through every tile
+std::size_t get_chunk_budget(const tmx::Map& map)
+{
+	for (const auto& prop: map.getProperties())
+	{
+		if (prop.getName() == "chunk_budget_kb" && prop.getType() == tmx::Property::Type::Int)
+		{
+			const auto kb = std::max(0, prop.getIntValue());
+			if (kb > 0)
+			{
+				LOG_INFO("Streaming map chunks with a budget of {0} kb per layer", kb);
+			}
+			return Cint_to_sizet(kb) * 1024;
+		}
+	}
+	return 0;
+}
+
+// pack all tileset images into a single texture, false if the images didn't fit
+bool load_tileset_atlas(MapImpl* impl, const std::vector<TilesetImage>& tilesets)
+{
+	std::vector<render::Image> images;
+	std::vector<glm::ivec2> sizes;
+	for (const auto& ts: tilesets)
+	{
+		auto image = load_image(ts.path);
+		if (image.pixels.empty())
+		{
+			return false;
+		}
+		sizes.emplace_back(image.width, image.height);
+		images.emplace_back(std::move(image));
+	}
+
+	if (images.empty())
+	{
+		return true;
+	}
+
+	const auto layout = get_atlas_layout(sizes, max_atlas_size);
+	if (layout.has_value() == false)
+	{
+		LOG_WARNING("Tilesets doesn't fit in a {0}x{0} atlas", max_atlas_size);
+		return false;
+	}
+
+	// textures are uploaded with the bottom row first
+	const auto width = Cint_to_sizet(layout->size.x);
+	const auto height = Cint_to_sizet(layout->size.y);
+	std::vector<u8> pixels(width * height * 4, 0);
+	for (std::size_t index = 0; index < images.size(); index += 1)
+	{
+		const auto& image = images[index];
+		const auto offset = layout->offsets[index];
+		const auto row_size = Cint_to_sizet(image.width) * 4;
+		for (std::size_t y = 0; y < Cint_to_sizet(image.height); y += 1)
+		{
+			const auto dest_y = height - 1 - (Cint_to_sizet(offset.y) + y);
+			std::copy_n(
+				image.pixels.begin() + static_cast<std::ptrdiff_t>(y * row_size),
+				row_size,
+				pixels.begin()
+					+ static_cast<std::ptrdiff_t>((dest_y * width + Cint_to_sizet(offset.x)) * 4)
+			);
+		}
+	}
+
+	auto texture = std::make_shared<render::Texture>(
+		pixels.data(),
+		layout->size.x,
+		layout->size.y,
+		render::TextureEdge::repeat,
+		render::TextureRenderStyle::pixel,
+		render::Transparency::include
+	);
+	for (std::size_t index = 0; index < tilesets.size(); index += 1)
+	{
+		impl->tileset_textures[tilesets[index].first_gid]
+			= TilesetTexture{texture, layout->size, layout->offsets[index], sizes[index]};
+	}
+
+	return true;
+}
+
+// without textures the tiles are placed as if each tileset had a texture of its own
+void load_tileset_textures(
+	MapImpl* impl, const std::vector<TilesetImage>& tilesets, bool atlas, TextureCache* textures
+)
+{
+	impl->tileset_textures.clear();
+	impl->tileset_images = tilesets;
+	impl->atlas = atlas;
+
+	if (textures == nullptr)
+	{
+		for (const auto& ts: tilesets)
+		{
+			impl->tileset_textures[ts.first_gid] = TilesetTexture{nullptr, ts.size, {0, 0}, ts.size};
+		}
 		return;
 	}
 
-	if (objects.size() != 1)
+	if (atlas && load_tileset_atlas(impl, tilesets))
 	{
-		std::cerr << "too many collisions: " << tile.imagePath << ": "
-				  << "id=" << tile.ID << " " << tile.imagePosition.x << " " << tile.imagePosition.y
-				  << " -> " << objects.size() << "\n";
 		return;
 	}
 
-	const auto& aabb = objects[0].getAABB();
-	impl->collisions.emplace_back(Rectf{aabb.width, aabb.height}.translate(pos.x, pos.y));
+	for (const auto& ts: tilesets)
+	{
+		auto texture = textures->get(ts.path);
+		const auto size = glm::ivec2{texture->width, texture->height};
+		impl->tileset_textures[ts.first_gid] = TilesetTexture{texture, size, {0, 0}, size};
+	}
+}
+
+// run the jobs on worker threads that take the next job when done, returns when all jobs are done
+// and rethrows the first exception a job threw
+void run_jobs(std::size_t count, int threads, const std::function<void(std::size_t)>& job)
+{
+	if (threads <= 0)
+	{
+		threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+	const auto worker_count = std::min(Cint_to_sizet(threads), count);
+
+	std::atomic<std::size_t> next = 0;
+	const auto work = [&]()
+	{
+		for (auto index = next++; index < count; index = next++)
+		{
+			job(index);
+		}
+	};
+
+	// the calling thread is one of the workers
+	std::vector<std::future<void>> workers;
+	for (std::size_t worker = 1; worker < worker_count; worker += 1)
+	{
+		workers.emplace_back(std::async(std::launch::async, work));
+	}
+	if (worker_count > 0)
+	{
+		work();
+	}
+	for (auto& worker: workers)
+	{
+		worker.get();
+	}
 }
 
 Map::Map()
@@ -680,24 +1614,122 @@ Map::Map()
 
 Map::~Map() = default;
 
-void Map::load_from_map(const tmx::Map& map)
+void Map::load_from_map(const tmx::Map& map, TextureCache* textures, int threads)
 {
 	impl->layers.clear();
+	impl->collisions.clear();
+	load_tileset_textures(impl.get(), get_tileset_images(map), is_atlas_requested(map), textures);
+
+	// cooking needs all the chunks
+	const auto budget = textures != nullptr ? get_chunk_budget(map) : 0;
 
+	auto hidden = get_hidden_tiles(map);
 	const auto& layers = map.getLayers();
 	for (std::size_t index = 0; index < layers.size(); index += 1)
 	{
-		auto loaded = make_layer(impl.get(), map, index);
+		auto loaded = make_layer(impl.get(), map, index, budget, std::move(hidden[index]));
 		if (loaded)
 		{
 			impl->layers.emplace_back(std::move(*loaded));
 		}
 	}
 
+	// the collisions of each layer and the chunks that aren't streamed are built in parallel
+	// while the textures and gpu buffers are created on this thread, the buffers when first drawn
+	struct LoadJob
+	{
+		std::size_t layer;
+		std::optional<std::size_t> chunk;	 // collisions if none
+	};
+	std::vector<LoadJob> jobs;
+	std::vector<std::vector<Rectf>> layer_collisions(impl->layers.size());
+	for (std::size_t layer = 0; layer < impl->layers.size(); layer += 1)
+	{
+		jobs.emplace_back(LoadJob{layer, std::nullopt});
+		if (impl->layers[layer].isStreamed() == false)
+		{
+			for (std::size_t chunk = 0; chunk < impl->layers[layer].m_chunks.size(); chunk += 1)
+			{
+				jobs.emplace_back(LoadJob{layer, chunk});
+			}
+		}
+	}
+	run_jobs(
+		jobs.size(),
+		threads,
+		[&](std::size_t index)
+		{
+			const auto& job = jobs[index];
+			auto& layer = impl->layers[job.layer];
+			if (job.chunk)
+			{
+				layer.buildChunk(*job.chunk);
+			}
+			else
+			{
+				layer_collisions[job.layer] = get_layer_collisions(*layer.m_source);
+			}
+		}
+	);
+	for (std::size_t layer = 0; layer < impl->layers.size(); layer += 1)
+	{
+		impl->layers[layer].finishBuilding();
+		const auto& collisions = layer_collisions[layer];
+		impl->collisions.insert(impl->collisions.end(), collisions.begin(), collisions.end());
+	}
+
 	const auto bounds = map.getBounds();
 	impl->bounds = Rectf{bounds.width, bounds.height};
 }
 
+void Map::write_cooked(CookedWriter* file) const
+{
+	file->write(static_cast<u8>(impl->atlas ? 1 : 0));
+	file->write(static_cast<std::uint32_t>(impl->tileset_images.size()));
+	for (const auto& ts: impl->tileset_images)
+	{
+		file->write(ts.first_gid);
+		file->write_string(ts.path);
+		file->write(ts.size);
+	}
+
+	const auto bounds = impl->bounds.value_or(Rectf{0.0f, 0.0f});
+	file->write(glm::vec2{bounds.get_width(), bounds.get_height()});
+
+	file->write(static_cast<std::uint32_t>(impl->layers.size()));
+	for (const auto& layer: impl->layers)
+	{
+		layer.writeCooked(file);
+	}
+}
+
+void Map::load_from_cooked(CookedReader* file, TextureCache* textures)
+{
+	impl->layers.clear();
+	impl->collisions.clear();
+
+	const auto atlas = file->read<u8>() != 0;
+	std::vector<TilesetImage> tilesets;
+	const auto tileset_count = file->read<std::uint32_t>();
+	for (std::uint32_t index = 0; index < tileset_count; index += 1)
+	{
+		const auto first_gid = file->read<std::uint32_t>();
+		auto path = file->read_string();
+		const auto size = file->read<glm::ivec2>();
+		tilesets.emplace_back(TilesetImage{first_gid, std::move(path), size});
+	}
+	load_tileset_textures(impl.get(), tilesets, atlas, textures);
+
+	const auto bounds = file->read<glm::vec2>();
+	impl->bounds = Rectf{bounds.x, bounds.y};
+
+	const auto layer_count = file->read<std::uint32_t>();
+	for (std::uint32_t index = 0; index < layer_count; index += 1)
+	{
+		impl->layers.emplace_back(impl.get(), file);
+	}
+}
+
 void Map::update(float dt)
 {
 	for (auto& layer: impl->layers)
@@ -708,12 +1740,23 @@ void Map::update(float dt)
 
 void Map::render(render::SpriteBatch& batch, const Rectf& view)
 {
+	const auto timer = render::ScopedTimer{&batch.render->profiler, "Map::render"};
 	for (auto& layer: impl->layers)
 	{
 		layer.draw(batch, view);
 	}
 }
 
+std::size_t Map::get_memory_usage() const
+{
+	std::size_t r = impl->collisions.size() * sizeof(Rectf);
+	for (const auto& layer: impl->layers)
+	{
+		r += layer.getMemoryUsage();
+	}
+	return r;
+}
+
 const std::vector<Rectf>& Map::get_collisions() const
 {
 	return impl->collisions;
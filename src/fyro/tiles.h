@@ -5,10 +5,45 @@
 
 #include "fyro/render/render2.h"
 #include "fyro/rect.h"
+#include "fyro/rendertypes.h"
 
 namespace tmx { class Map; }
 
 struct MapImpl;
+struct CookedWriter;
+struct CookedReader;
+
+/** A range of chunks, the end is exclusive */
+struct ChunkRange
+{
+	glm::ivec2 begin;
+	glm::ivec2 end;
+
+	bool empty() const;
+};
+
+/// the chunks that overlap the view, the chunks are counted from the top of the map like in tmx
+/// while the view is in world space where y goes up from the bottom of the map
+ChunkRange get_visible_chunks(
+	const Rectf& view, const glm::ivec2& chunk_size, const glm::ivec2& chunk_count, float map_height
+);
+
+/** Where each image is placed in a atlas */
+struct AtlasLayout
+{
+	glm::ivec2 size;
+	std::vector<glm::ivec2> offsets;  // in pixels from the top left, one per image
+};
+
+/// pack images of the sizes into the smallest power of two atlas, none if they don't fit max_size
+std::optional<AtlasLayout> get_atlas_layout(const std::vector<glm::ivec2>& sizes, int max_size);
+
+/// the tiles of each tile layer that are covered by a opaque tile on a layer that is drawn later,
+/// opaque_tiles are the opaque tiles of each tileset from the first gid, only tiles with the map
+/// tile size and no offset on a layer without offset can cover or be covered
+std::vector<std::vector<bool>> get_hidden_tiles(
+	const tmx::Map& map, const std::vector<std::vector<bool>>& opaque_tiles
+);
 
 struct Map
 {
@@ -17,10 +52,27 @@ struct Map
 	Map();
 	~Map();
 
-	void load_from_map(const tmx::Map& map);
+	/// the tileset textures are shared through the cache, unless the map has the bool property
+	/// "atlas" set, then all the tilesets are packed into a single texture owned by the map
+	/// without a cache no textures are loaded, the map can only be cooked
+	/// tiles under opaque tiles on layers above are not drawn if the bool property
+	/// "cull_hidden_tiles" is set, the opaque tiles are found from the tileset images
+	/// the chunks and collisions are built on threads, 0 uses a thread per core
+	/// with the int property "chunk_budget_kb" the chunks are only built near the view and evicted
+	/// when a layer uses more than the budget, this bounds the chunk geometry but not the load
+	/// time, the tiles, collisions, hidden tiles and animations are still read for the whole map
+	void load_from_map(const tmx::Map& map, TextureCache* textures, int threads = 0);
+
+	/// the prebuilt tiles, the collisions are not part of the cooked map
+	void write_cooked(CookedWriter* file) const;
+	void load_from_cooked(CookedReader* file, TextureCache* textures);
 	void update(float dt);
+	/// view is the world space rect the camera sees
 	void render(render::SpriteBatch& batch, const Rectf& view);
 
+	/// estimated bytes used by the built chunks and the collisions
+	std::size_t get_memory_usage() const;
+
 	const std::vector<Rectf>& get_collisions() const;
 	std::optional<Rectf> get_bounds() const;
 };
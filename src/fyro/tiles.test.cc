@@ -0,0 +1,224 @@
+#include "catch.hpp"
+
+#include "fyro/tiles.h"
+#include "fyro/tiles.benchmark.h"
+
+#include <thread>
+
+#include <tmxlite/Map.hpp>
+
+namespace
+{
+	// a 1000x600 map with 512x512 chunks, the last column and row are partial
+	constexpr float map_height = 600.0f;
+	const auto chunk_size = glm::ivec2{512, 512};
+	const auto chunk_count = glm::ivec2{2, 2};
+
+	ChunkRange get_chunks(const Rectf& view)
+	{
+		return get_visible_chunks(view, chunk_size, chunk_count, map_height);
+	}
+
+	Rectf view_at(float x, float y)
+	{
+		return Rectf{200.0f, 200.0f}.translate(x, y);
+	}
+
+	void load_synthetic_tmx(tmx::Map* map, int width, int height)
+	{
+		auto settings = SyntheticMap{};
+		settings.width = width;
+		settings.height = height;
+		REQUIRE(map->loadFromString(make_synthetic_tmx(settings), ""));
+	}
+}  //  namespace
+
+TEST_CASE("tiles: visible chunks", "[tiles]")
+{
+	SECTION("bottom left of the map covers both tmx rows")
+	{
+		const auto r = get_chunks(view_at(0.0f, 0.0f));
+		CHECK(r.begin == glm::ivec2{0, 0});
+		CHECK(r.end == glm::ivec2{1, 2});
+	}
+
+	SECTION("top left of the map is the first tmx row")
+	{
+		const auto r = get_chunks(view_at(0.0f, 400.0f));
+		CHECK(r.begin == glm::ivec2{0, 0});
+		CHECK(r.end == glm::ivec2{1, 1});
+	}
+
+	SECTION("inside a single chunk")
+	{
+		const auto r = get_chunks(view_at(600.0f, 100.0f));
+		CHECK(r.begin == glm::ivec2{1, 0});
+		CHECK(r.end == glm::ivec2{2, 1});
+	}
+
+	SECTION("across a chunk border")
+	{
+		const auto r = get_chunks(view_at(412.0f, 100.0f));
+		CHECK(r.begin == glm::ivec2{0, 0});
+		CHECK(r.end == glm::ivec2{2, 1});
+	}
+
+	SECTION("touching a chunk doesn't make it visible")
+	{
+		const auto r = get_chunks(view_at(512.0f, 400.0f));
+		CHECK(r.begin == glm::ivec2{1, 0});
+		CHECK(r.end == glm::ivec2{2, 1});
+	}
+
+	SECTION("outside of the map")
+	{
+		CHECK(get_chunks(view_at(-500.0f, -500.0f)).empty());
+		CHECK(get_chunks(view_at(1200.0f, 100.0f)).empty());
+		CHECK(get_chunks(view_at(100.0f, 700.0f)).empty());
+	}
+
+	SECTION("larger than the map")
+	{
+		const auto r = get_chunks(Rectf{-100.0f, -100.0f, 2000.0f, 2000.0f});
+		CHECK(r.begin == glm::ivec2{0, 0});
+		CHECK(r.end == glm::ivec2{2, 2});
+	}
+}
+
+TEST_CASE("tiles: atlas layout", "[tiles]")
+{
+	SECTION("a single image uses the smallest power of two")
+	{
+		const auto layout = get_atlas_layout({{100, 60}}, 4096);
+		REQUIRE(layout.has_value());
+		CHECK(layout->size == glm::ivec2{128, 128});
+		REQUIRE(layout->offsets.size() == 1);
+		CHECK(layout->offsets[0] == glm::ivec2{0, 0});
+	}
+
+	SECTION("images don't overlap")
+	{
+		const auto sizes = std::vector<glm::ivec2>{{256, 128}, {64, 64}, {128, 256}, {32, 16}};
+		const auto layout = get_atlas_layout(sizes, 4096);
+		REQUIRE(layout.has_value());
+		REQUIRE(layout->offsets.size() == sizes.size());
+
+		const auto get_rect = [&](std::size_t index)
+		{
+			return Recti::from_xywh(
+				layout->offsets[index].x, layout->offsets[index].y, sizes[index].x, sizes[index].y
+			);
+		};
+		for (std::size_t lhs = 0; lhs < sizes.size(); lhs += 1)
+		{
+			CHECK(get_rect(lhs).right <= layout->size.x);
+			CHECK(get_rect(lhs).top <= layout->size.y);
+			for (std::size_t rhs = lhs + 1; rhs < sizes.size(); rhs += 1)
+			{
+				CHECK_FALSE(rect_intersect(get_rect(lhs), get_rect(rhs)));
+			}
+		}
+	}
+
+	SECTION("too large")
+	{
+		CHECK_FALSE(get_atlas_layout({{300, 300}, {300, 300}}, 512).has_value());
+	}
+}
+
+TEST_CASE("tiles: hidden tiles", "[tiles]")
+{
+	// 16x16 tiles, 16x32 trees and 16x16 tiles drawn 4 pixels down, the top layer is all opaque
+	const auto get_tmx = [](const std::string& lower_layer_attributes)
+	{
+		return fmt::format(
+			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<map version=\"1.8\" orientation=\"orthogonal\" renderorder=\"right-down\" "
+			"width=\"4\" height=\"1\" tilewidth=\"16\" tileheight=\"16\" infinite=\"0\">\n"
+			"<tileset firstgid=\"1\" name=\"tiles\" tilewidth=\"16\" tileheight=\"16\" "
+			"tilecount=\"4\" columns=\"2\">\n"
+			"<image source=\"tiles.png\" width=\"32\" height=\"32\"/>\n"
+			"</tileset>\n"
+			"<tileset firstgid=\"5\" name=\"trees\" tilewidth=\"16\" tileheight=\"32\" "
+			"tilecount=\"2\" columns=\"2\">\n"
+			"<image source=\"trees.png\" width=\"32\" height=\"32\"/>\n"
+			"</tileset>\n"
+			"<tileset firstgid=\"7\" name=\"moved\" tilewidth=\"16\" tileheight=\"16\" "
+			"tilecount=\"4\" columns=\"2\">\n"
+			"<tileoffset x=\"0\" y=\"4\"/>\n"
+			"<image source=\"moved.png\" width=\"32\" height=\"32\"/>\n"
+			"</tileset>\n"
+			"<layer id=\"1\" name=\"lower\" width=\"4\" height=\"1\" {0}>"
+			"<data encoding=\"csv\">\n1,5,7,0\n</data></layer>\n"
+			"<layer id=\"2\" name=\"upper\" width=\"4\" height=\"1\">"
+			"<data encoding=\"csv\">\n2,2,2,2\n</data></layer>\n"
+			"</map>\n",
+			lower_layer_attributes
+		);
+	};
+	const auto opaque_tiles = std::vector<std::vector<bool>>{{true, true, true, true}, {}, {}};
+
+	SECTION("only tiles drawn inside the covered cell are hidden")
+	{
+		tmx::Map source;
+		REQUIRE(source.loadFromString(get_tmx(""), ""));
+
+		const auto hidden = get_hidden_tiles(source, opaque_tiles);
+		REQUIRE(hidden.size() == 2);
+		CHECK(hidden[0] == std::vector<bool>{true, false, false, false});
+		CHECK(hidden[1].empty());
+	}
+
+	SECTION("a moved layer isn't hidden")
+	{
+		tmx::Map source;
+		REQUIRE(source.loadFromString(get_tmx("offsetx=\"8\""), ""));
+
+		const auto hidden = get_hidden_tiles(source, opaque_tiles);
+		REQUIRE(hidden.size() == 2);
+		CHECK(hidden[0].empty());
+		CHECK(hidden[1].empty());
+	}
+}
+
+TEST_CASE("tiles: loading on threads gives the same collisions", "[tiles]")
+{
+	tmx::Map source;
+	load_synthetic_tmx(&source, 100, 70);
+
+	// without a texture cache the map is loaded as when cooking
+	Map single;
+	single.load_from_map(source, nullptr, 1);
+	Map threaded;
+	threaded.load_from_map(source, nullptr, 4);
+
+	const auto& lhs = single.get_collisions();
+	const auto& rhs = threaded.get_collisions();
+	CHECK_FALSE(lhs.empty());
+	REQUIRE(lhs.size() == rhs.size());
+	for (std::size_t index = 0; index < lhs.size(); index += 1)
+	{
+		CHECK(lhs[index].left == rhs[index].left);
+		CHECK(lhs[index].bottom == rhs[index].bottom);
+		CHECK(lhs[index].right == rhs[index].right);
+		CHECK(lhs[index].top == rhs[index].top);
+	}
+}
+
+TEST_CASE("tiles: load benchmark", "[tiles][!benchmark]")
+{
+	// 32x32 chunks per layer
+	tmx::Map source;
+	load_synthetic_tmx(&source, 1024, 1024);
+
+	const auto cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	for (int threads = 1; threads <= cores; threads *= 2)
+	{
+		BENCHMARK(fmt::format("load a 1024x1024 map with 2 layers on {0} threads", threads))
+		{
+			Map map;
+			map.load_from_map(source, nullptr, threads);
+			return map.get_collisions().size();
+		};
+	}
+}
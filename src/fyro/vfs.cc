@@ -43,6 +43,16 @@ std::optional<std::vector<char>> read_file_to_bytes_or_none(const std::string& p
 	}
 
 	std::vector<char> ret;
+
+	// read everything at once when the size is known
+	const auto length = PHYSFS_fileLength(file);
+	if (length > 0)
+	{
+		ret.resize(static_cast<std::size_t>(length));
+		const auto read = PHYSFS_readBytes(file, ret.data(), static_cast<PHYSFS_uint64>(length));
+		ret.resize(read > 0 ? static_cast<std::size_t>(read) : 0);
+	}
+
 	while (PHYSFS_eof(file) == 0)
 	{
 		constexpr u64 buffer_size = 1024;
@@ -88,6 +98,23 @@ std::vector<char> read_file_to_bytes(const std::string& path)
 	}
 }
 
+void write_file_from_bytes(const std::string& path, const std::vector<char>& bytes)
+{
+	auto* file = PHYSFS_openWrite(path.c_str());
+	if (file == nullptr)
+	{
+		throw physfs_exception("unable to open file for writing: ");
+	}
+
+	const auto written = PHYSFS_writeBytes(file, bytes.data(), bytes.size());
+	PHYSFS_close(file);
+
+	if (written < 0 || static_cast<std::size_t>(written) != bytes.size())
+	{
+		throw physfs_exception("unable to write file: ");
+	}
+}
+
 std::optional<std::string> read_file_to_string_or_none(const std::string& path)
 {
 	if (auto ret = read_file_to_bytes_or_none(path))
@@ -145,3 +172,11 @@ void Physfs::setup_with_default_root()
 {
 	setup(PHYSFS_getBaseDir());
 }
+
+void Physfs::setup_write_root(const std::string& root)
+{
+	if (PHYSFS_setWriteDir(root.c_str()) == 0)
+	{
+		throw physfs_exception("unable to set write dir: ");
+	}
+}
@@ -11,9 +11,14 @@ struct Physfs
 	~Physfs();
 	void setup(const std::string& root);
 	void setup_with_default_root();
+
+	/// where write_file_from_bytes writes to
+	void setup_write_root(const std::string& root);
 };
 
 std::vector<char> read_file_to_bytes(const std::string& path);
+std::optional<std::vector<char>> read_file_to_bytes_or_none(const std::string& path);
+void write_file_from_bytes(const std::string& path, const std::vector<char>& bytes);
 
 std::string read_file_to_string(const std::string& path);
 std::optional<std::string> read_file_to_string_or_none(const std::string& path);